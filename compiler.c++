@@ -1,51 +1,433 @@
 #include <fstream>
 #include <cstdarg>
 #include <stdio.h>
+#include <utility>
 #include "argparse/argparse-2.2/include/argparse/argparse.hpp"
 #include <vector>
-#include <regex>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <charconv>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <array>
+#include <filesystem>
 
-std::string escape(std::string str) {
-	std::string str2 = "";
+#if (defined(__x86_64__) or defined(__i386__) and defined(__SSE2__)) and defined(__GNUC__)
+#define CFUSS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#if defined(__unix__) or defined(__APPLE__)
+#define CFUSS_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#include <spawn.h>
+extern char** environ;
+#endif
+
+// appends the escaped str to out, so one buffer can be reused for many strings
+void escape(std::string_view str, std::string& out) {
 	for (int i = 0; i < str.size(); i++){
 		switch (str[i]){
 			case '\n':
-				str2 += "\\n";
+				out += "\\n";
 				break;
 			case '\t':
-				str2 += "\\t";
+				out += "\\t";
 				break;
 			case '\"':
-				str2 += "\\\"";
+				out += "\\\"";
 				break;
 			default:
-				str2 += str[i];
+				out += str[i];
 				break;
 		}
 	}
+}
+
+std::string escape(std::string_view str) {
+	std::string str2 = "";
+	escape(str, str2);
 	return str2;
 }
 
-// From https://stackoverflow.com/a/13172514/12469275
-std::vector<std::string> split_string(
-	const std::string& str,
-	const std::string& delimiter
-)
-{
-	std::vector<std::string> strings;
-
-	std::string::size_type pos = 0;
-	std::string::size_type prev = 0;
-	while ((pos = str.find(delimiter, prev)) != std::string::npos)
-	{
-		strings.push_back(str.substr(prev, pos - prev));
-		prev = pos + 1;
+// the length escape would give, without building the string
+size_t escaped_length(std::string_view str) {
+	size_t length = str.size();
+	for (char c : str)
+		if (c == '\n' or c == '\t' or c == '\"')
+			length++;
+	return length;
+}
+
+// the argument quoted for the shell, so paths with spaces and the like make it through std::system where there is no posix_spawn
+std::string quote(std::string_view argument){
+	#ifdef CFUSS_POSIX
+	std::string quoted = "'";
+	for (char c : argument){
+		if (c == '\'')
+			quoted += "'\\''";
+		else
+			quoted += c;
+	}
+	return quoted + "'";
+	#else
+	return "\"" + std::string(argument) + "\"";
+	#endif
+}
+
+namespace Threads{
+
+	// index of the thread in the pool it works for, 0 for any other thread, which is the calling one while it runs a job
+	thread_local int index = 0;
+
+	/**
+	 * a fixed set of worker threads, which split the indices of a job between them
+	 *
+	 * the calling thread works on the job too, jobs cannot be nested or run from several threads at once,
+	 * so during a job index tells the threads apart, for state they keep between the indices they get
+	 */
+	class Pool{
+		public:
+			Pool(int threads){
+				for (int i = 1; i < threads; i++)
+					workers.emplace_back([this, i]{
+						index = i;
+						work();
+					});
+			}
+
+			~Pool(){
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopping = true;
+				}
+				wake.notify_all();
+				for (std::thread& worker : workers)
+					worker.join();
+			}
+
+			// number of threads working on a job, including the calling one
+			int size() const{
+				return workers.size() + 1;
+			}
+
+			// calls task(i) for every i in [0, count) and returns once all of them are done
+			void run(int count, const std::function<void(int)>& task){
+				if (workers.empty() or count <= 1){
+					for (int i = 0; i < count; i++)
+						task(i);
+					return;
+				}
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					this->task = &task;
+					this->count = count;
+					next = 0;
+					busy = workers.size();
+					generation++;
+				}
+				wake.notify_all();
+				drain();
+				std::unique_lock<std::mutex> lock(mutex);
+				done.wait(lock, [this]{ return busy == 0; });
+				this->task = nullptr;
+			}
+
+		private:
+			std::vector<std::thread> workers;
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::condition_variable done;
+			const std::function<void(int)>* task = nullptr;
+			int count = 0;
+			std::atomic<int> next{0};
+			// workers which have not finished the current job yet
+			int busy = 0;
+			unsigned long generation = 0;
+			bool stopping = false;
+
+			void drain(){
+				for (int i = next++; i < count; i = next++)
+					(*task)(i);
+			}
+
+			void work(){
+				unsigned long seen = 0;
+				for (;;){
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [&]{ return stopping or generation != seen; });
+					if (stopping)
+						return;
+					seen = generation;
+					lock.unlock();
+					drain();
+					lock.lock();
+					if (--busy == 0)
+						done.notify_all();
+				}
+			}
+	};
+
+	int cores(){
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	/**
+	 * the shared pool, with a thread for every core
+	 *
+	 * its threads are started the first time it is asked for, so it is only asked for once there is enough work to split
+	 */
+	Pool& pool(){
+		static Pool shared(cores());
+		return shared;
+	}
+
+}
+
+namespace Memory{
+
+	// every heap allocation of the program, counted by the operator new below, shown with --alloc-stats
+	// without it the counters are left alone, so allocating costs no more than the flag check
+	std::atomic<bool> counting{false};
+	std::atomic<size_t> allocations{0};
+	std::atomic<size_t> allocated_bytes{0};
+
+	/**
+	 * bump pointer allocator, everything allocated from it stays where it is until the arena goes away
+	 *
+	 * destructors are never run, so it only holds trivially destructible things
+	 */
+	class Arena{
+		public:
+			Arena() = default;
+			Arena(const Arena&) = delete;
+			Arena& operator=(const Arena&) = delete;
+			// the blocks stay where they are, so moving keeps what was allocated valid,
+			// and the arena moved from is left empty, it starts a block of its own when it is used again
+			Arena(Arena&& other) noexcept{
+				*this = std::move(other);
+			}
+
+			Arena& operator=(Arena&& other) noexcept{
+				if (this != &other){
+					blocks = std::move(other.blocks);
+					other.blocks.clear();
+					current = std::exchange(other.current, nullptr);
+					block_size = std::exchange(other.block_size, BLOCK_SIZE);
+					block_used = std::exchange(other.block_used, BLOCK_SIZE);
+					allocated = std::exchange(other.allocated, 0);
+				}
+				return *this;
+			}
+
+			void* allocate(size_t size, size_t align = alignof(std::max_align_t)){
+				size_t start = (block_used + align - 1) & ~(align - 1);
+				if (start + size > block_size){
+					if (size > MAX_BLOCK_SIZE / 4){
+						// big allocations get a block of their own, the current one stays open
+						blocks.emplace_back(new char[size]);
+						allocated += size;
+						return blocks.back().get();
+					}
+					// blocks grow, so a big input does not end up in thousands of them
+					if (current != nullptr and block_size < MAX_BLOCK_SIZE)
+						block_size *= 2;
+					while (block_size < size)
+						block_size *= 2;
+					blocks.emplace_back(new char[block_size]);
+					current = blocks.back().get();
+					start = 0;
+				}
+				block_used = start + size;
+				allocated += size;
+				return current + start;
+			}
+
+			template<typename T, typename... Args>
+			T* make(Args&&... args){
+				return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			}
+
+			template<typename T>
+			T* copy(const T* items, size_t count){
+				if (count == 0)
+					return nullptr;
+				T* to = (T*) allocate(sizeof(T) * count, alignof(T));
+				std::uninitialized_copy(items, items + count, to);
+				return to;
+			}
+
+			std::string_view copy(std::string_view text){
+				return std::string_view(copy(text.data(), text.size()), text.size());
+			}
+
+			// bytes handed out so far
+			size_t size() const{
+				return allocated;
+			}
+
+		private:
+			static constexpr size_t BLOCK_SIZE = 1 << 16;
+			static constexpr size_t MAX_BLOCK_SIZE = 1 << 24;
+
+			std::vector<std::unique_ptr<char[]>> blocks;
+			char* current = nullptr;
+			size_t block_size = BLOCK_SIZE;
+			size_t block_used = BLOCK_SIZE;
+			size_t allocated = 0;
+	};
+
+	// a list which lives in an arena, it never grows after it is made
+	template<typename T>
+	struct List{
+		T* items;
+		uint32_t count;
+
+		T* begin() const{
+			return items;
+		}
+
+		T* end() const{
+			return items + count;
+		}
+
+		size_t size() const{
+			return count;
+		}
+
+		T& operator[](size_t i) const{
+			return items[i];
+		}
+	};
+
+}
+
+void* operator new(size_t size){
+	if (Memory::counting.load(std::memory_order_relaxed)){
+		Memory::allocations.fetch_add(1, std::memory_order_relaxed);
+		Memory::allocated_bytes.fetch_add(size, std::memory_order_relaxed);
 	}
+	void* memory = std::malloc(size == 0 ? 1 : size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept{
+	std::free(memory);
+}
+
+namespace Symbols{
+
+	// id of an interned name, 0 is not a name
+	typedef uint32_t Symbol;
+	const Symbol NONE = 0;
+
+	/**
+	 * every distinct name is stored once, in an arena that lives as long as the table,
+	 * and is known by its id from then on, so comparing names is comparing integers
+	 *
+	 * not thread safe, interning happens between the parallel parts
+	 */
+	class Interner{
+		public:
+			Interner(){
+				names.push_back({});
+				hashes.push_back(0);
+				slots.assign(1024, NONE);
+			}
+
+			Symbol intern(std::string_view name){
+				uint32_t h = hash(name);
+				size_t mask = slots.size() - 1;
+				for (size_t slot = h & mask;; slot = (slot + 1) & mask){
+					Symbol symbol = slots[slot];
+					if (symbol == NONE){
+						symbol = names.size();
+						names.push_back(strings.copy(name));
+						hashes.push_back(h);
+						slots[slot] = symbol;
+						// keep the table at most half full
+						if (names.size() * 2 > slots.size())
+							grow();
+						return symbol;
+					}
+					if (hashes[symbol] == h and names[symbol] == name)
+						return symbol;
+				}
+			}
+
+			// NONE if the name was never interned
+			Symbol find(std::string_view name) const{
+				uint32_t h = hash(name);
+				size_t mask = slots.size() - 1;
+				for (size_t slot = h & mask;; slot = (slot + 1) & mask){
+					Symbol symbol = slots[slot];
+					if (symbol == NONE or hashes[symbol] == h and names[symbol] == name)
+						return symbol;
+				}
+			}
+
+			std::string_view name(Symbol symbol) const{
+				return names[symbol];
+			}
+
+			// number of names, including the NONE one
+			size_t size() const{
+				return names.size();
+			}
+
+		private:
+			Memory::Arena strings;
+			std::vector<std::string_view> names;
+			std::vector<uint32_t> hashes;
+			// open addressing, the size is a power of two
+			std::vector<Symbol> slots;
+
+			static uint32_t hash(std::string_view name){
+				// FNV-1a
+				uint32_t h = 2166136261u;
+				for (unsigned char c : name)
+					h = (h ^ c) * 16777619u;
+				return h;
+			}
 
-	// To get the last substring (or only, if delimiter is not found)
-	strings.push_back(str.substr(prev));
+			void grow(){
+				slots.assign(slots.size() * 2, NONE);
+				size_t mask = slots.size() - 1;
+				for (Symbol symbol = 1; symbol < names.size(); symbol++){
+					size_t slot = hashes[symbol] & mask;
+					while (slots[slot] != NONE)
+						slot = (slot + 1) & mask;
+					slots[slot] = symbol;
+				}
+			}
+	};
+
+	// the table shared by the lexer and the parser
+	Interner& table(){
+		static Interner shared;
+		return shared;
+	}
 
-	return strings;
 }
 
 namespace Lexer{
@@ -75,84 +457,222 @@ namespace Lexer{
 	// bitmap for which keywords end whitespace ignoring
 	const int stop_ws_ignore = (1 << TOKEN_QUOTE) + (1 << TOKEN_MULTILINE_STRING_END) + (1 << TOKEN_NEWLINE);
 
-	struct Token{
-		TokenType type;
-		std::string value;
-		std::string debug;
-		int line;
+	// flags stored in TokenBuffer::debug, see debug_string
+	enum TokenDebug{
+		DEBUG_NOT_SPACE = 1 << 0, // the token was ended by something else than a space
+		DEBUG_CATCHING  = 1 << 1, // whitespace was being caught
+		DEBUG_WORD      = 1 << 2, // word token
+		DEBUG_AFTER     = 2 << 2, // special token, added right after a word token
+		DEBUG_START_WS  = 1 << 4, // turned whitespace catching on
+		DEBUG_STOP_WS   = 2 << 4, // turned whitespace catching off
 	};
 
-	namespace RegexPatterns{
-		std::basic_regex<char> LIT_NUMBER(R"(\d+(\.\d+)?)");
-		std::basic_regex<char> IDENTIFIER(R"([a-zA-Z_][a-zA-Z0-9_]*(\\.[a-zA-Z_][a-zA-Z0-9_]*)*)");
+	/**
+	 * where the lines of a source buffer start, the lexer builds it as a by-product
+	 */
+	struct LineIndex{
+		std::string_view code;
+		// offset of the first byte of each line, the first line starts at 0
+		std::vector<uint32_t> starts;
 
-		std::basic_regex<char> ALL_PATTERNS[] = {
-			LIT_NUMBER,
-			IDENTIFIER
+		struct Position{
+			// both start at 1, columns count bytes
+			int line;
+			int column;
 		};
 
-		int PATTERN_COUNT = 2;
-		//map of keywords to token types
-		TokenType map[] = {
-			TOKEN_NUMBER,
-			TOKEN_IDENTIFIER
-		};
+		int count() const{
+			return starts.size();
+		}
+
+		int line(uint32_t offset) const{
+			return std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin();
+		}
+
+		Position locate(uint32_t offset) const{
+			int found = line(offset);
+			return {found, (int) (offset - starts[found-1]) + 1};
+		}
+
+		// for code which was not lexed, like when its tree came from the cache, the lexer finds the lines on the way
+		void build(std::string_view code){
+			this->code = code;
+			starts.assign(1, 0);
+			const char* end = code.data() + code.size();
+			for (const char* at = code.data(); (at = (const char*) std::memchr(at, '\n', end - at)) != nullptr;)
+				starts.push_back(++at - code.data());
+		}
+
+		// the text of a line, without its newline
+		std::string_view text(int line) const{
+			uint32_t start = starts[line-1];
+			uint32_t end = line < count() ? starts[line] - 1 : code.size();
+			return code.substr(start, end - start);
+		}
+	};
+
+	/**
+	 * the tokens of a source buffer, stored as parallel arrays, a token is an index into them
+	 *
+	 * tokens do not own their text, they point into the source buffer, which has to outlive them
+	 */
+	struct TokenBuffer{
+		std::string_view code;
+		std::vector<uint8_t> types;
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> lengths;
+		// only filled in when tracing, see tokenize
+		std::vector<uint8_t> debug;
+		// interned name of identifier tokens, Symbols::NONE for the rest
+		std::vector<Symbols::Symbol> symbols;
+		// the token on the other side of a bracket or string, see match_pairs
+		std::vector<uint32_t> partners;
+		LineIndex lines;
+
+		size_t size() const{
+			return types.size();
+		}
+
+		TokenType type(size_t i) const{
+			return (TokenType) types[i];
+		}
+
+		std::string_view value(size_t i) const{
+			return code.substr(offsets[i], lengths[i]);
+		}
+
+		// line numbers start at 1
+		int line(size_t i) const{
+			return lines.line(offsets[i]);
+		}
+
+		void push(TokenType type, uint32_t offset, uint32_t length){
+			types.push_back(type);
+			offsets.push_back(offset);
+			lengths.push_back(length);
+		}
+
+		void reserve(size_t count, bool with_debug){
+			types.reserve(count);
+			offsets.reserve(count);
+			lengths.reserve(count);
+			if (with_debug)
+				debug.reserve(count);
+		}
+	};
+
+	const uint32_t NO_PARTNER = UINT32_MAX;
+
+	// offsets and lengths of tokens are 32 bit, so a source can not be longer than this
+	const size_t MAX_SIZE = UINT32_MAX;
+
+	// a guess at the number of tokens in so many bytes of source, on the high side so buffers rarely have to grow
+	size_t expected_tokens(size_t bytes){
+		return bytes / 4 + 16;
+	}
+
+	std::string debug_string(unsigned char debug){
+		std::string str;
+		str += debug & DEBUG_NOT_SPACE ? 'S' : 'W';
+		str += debug & DEBUG_CATCHING  ? 'C' : ' ';
+		str += "abc"[debug >> 2 & 3];
+		if (debug & DEBUG_START_WS)
+			str += '+';
+		if (debug & DEBUG_STOP_WS)
+			str += '-';
+		return str;
 	}
 
 	namespace Keywords{
-		std::string VOID      =      "void";
-		std::string NUM       =       "num";
-		std::string STR       =       "str";
-		std::string NULL_U    =      "NULL";
-		std::string NULL_L    =      "null";
-		std::string TRUE      =      "true";
-		std::string FALSE     =     "false";
-		std::string STATIC    =    "static";
-		std::string MACRO     =     "macro";
-		std::string FUNC      =      "func";
-		std::string NAMESPACE = "namespace";
-		std::string MERGE     =     "merge";
-		std::string TO        =        "to";
-		std::string SERVE     =     "serve";
-		std::string STRUCT    = "structure";
-
-		std::string ALL_KEYWORDS[] = {
-			VOID,
-			NUM,
-			STR,
-			NULL_U,
-			NULL_L,
-			TRUE,
-			FALSE,
-			STATIC,
-			MACRO,
-			FUNC,
-			NAMESPACE,
-			MERGE,
-			TO,
-			SERVE,
-			STRUCT
+		struct Keyword{
+			std::string_view name;
+			TokenType type;
 		};
 
-		int KEYWORD_COUNT = 13;
-		//map of keywords to token types
-		TokenType map[] = {
-			TOKEN_TYPE,
-			TOKEN_TYPE,
-			TOKEN_TYPE,
-			TOKEN_NULL,
-			TOKEN_NULL,
-			TOKEN_NUMBER,
-			TOKEN_NUMBER,
-			TOKEN_KEYWORD,
-			TOKEN_KEYWORD,
-			TOKEN_KEYWORD,
-			TOKEN_KEYWORD,
-			TOKEN_KEYWORD,
-			TOKEN_KEYWORD,
-			TOKEN_KEYWORD
+		// every keyword with the type of token it becomes, adding a line here is all it takes
+		constexpr Keyword ALL_KEYWORDS[] = {
+			{"void",      TOKEN_TYPE},
+			{"num",       TOKEN_TYPE},
+			{"str",       TOKEN_TYPE},
+			{"NULL",      TOKEN_NULL},
+			{"null",      TOKEN_NULL},
+			{"true",      TOKEN_NUMBER},
+			{"false",     TOKEN_NUMBER},
+			{"static",    TOKEN_KEYWORD},
+			{"macro",     TOKEN_KEYWORD},
+			{"func",      TOKEN_KEYWORD},
+			{"namespace", TOKEN_KEYWORD},
+			{"merge",     TOKEN_KEYWORD},
+			{"to",        TOKEN_KEYWORD},
+			{"serve",     TOKEN_KEYWORD},
+			{"structure", TOKEN_KEYWORD},
+		};
+
+		constexpr int KEYWORD_COUNT = sizeof(ALL_KEYWORDS) / sizeof(ALL_KEYWORDS[0]);
+
+		/**
+		 * keywords are found with a perfect hash, the seed for it is searched for at compile time,
+		 * so every keyword lands in its own slot and a lookup is one hash and at most one compare
+		 */
+		constexpr int TABLE_BITS = 6;
+		constexpr int TABLE_SIZE = 1 << TABLE_BITS;
+		static_assert(TABLE_SIZE >= KEYWORD_COUNT * 2, "keyword table is too crowded, increase TABLE_BITS");
+
+		// only the length and the first, second and last chars are mixed in, which is enough for these
+		constexpr uint32_t hash(std::string_view word, uint32_t seed){
+			uint32_t key = word.size();
+			if (!word.empty())
+				key |= (unsigned char) word[0] << 8 | (unsigned char) word[word.size()/2] << 16 | (unsigned char) word.back() << 24;
+			key ^= key >> 13;
+			return key * seed >> (32 - TABLE_BITS);
+		}
+
+		constexpr bool is_perfect(uint32_t seed){
+			bool used[TABLE_SIZE] = {};
+			for (int i = 0; i < KEYWORD_COUNT; i++){
+				uint32_t slot = hash(ALL_KEYWORDS[i].name, seed);
+				if (used[slot])
+					return false;
+				used[slot] = true;
+			}
+			return true;
+		}
+
+		constexpr uint32_t find_seed(){
+			for (uint32_t seed = 0x9E3779B1; seed < 0x9E3779B1 + 20000; seed += 2)
+				if (is_perfect(seed))
+					return seed;
+			return 0;
+		}
+
+		constexpr uint32_t SEED = find_seed();
+		static_assert(SEED != 0, "no perfect hash seed found for the keywords, increase TABLE_BITS");
+
+		struct Table{
+			// index into ALL_KEYWORDS, -1 for empty slots
+			signed char slots[TABLE_SIZE];
 		};
 
+		constexpr Table build_table(){
+			Table table = {};
+			for (int i = 0; i < TABLE_SIZE; i++)
+				table.slots[i] = -1;
+			for (int i = 0; i < KEYWORD_COUNT; i++)
+				table.slots[hash(ALL_KEYWORDS[i].name, SEED)] = i;
+			return table;
+		}
+
+		constexpr Table TABLE = build_table();
+
+		// the token type of a keyword, TOKEN_UNKNOWN if the word is not one
+		constexpr TokenType lookup(std::string_view word){
+			int slot = TABLE.slots[hash(word, SEED)];
+			if (slot < 0 or ALL_KEYWORDS[slot].name != word)
+				return TOKEN_UNKNOWN;
+			return ALL_KEYWORDS[slot].type;
+		}
+
+		static_assert(lookup("structure") == TOKEN_KEYWORD and lookup("null") == TOKEN_NULL and lookup("nul") == TOKEN_UNKNOWN);
 	}
 
 	namespace SCTokens{
@@ -237,180 +757,723 @@ namespace Lexer{
 		};
 	}
 
-	std::vector<Token> tokenize(std::string code){
-		std::vector<Token> tokens;
+	namespace Table{
+
+		// what a single byte does to the lexer
+		enum CharAction{
+			CHAR_WORD,    // becomes part of the current word
+			CHAR_BLANK,   // separates words, unless whitespace is caught
+			CHAR_SPECIAL, // starts a single or multi char token
+		};
 
-		code += ' '; //ensure that no trailing tokens are missed
-		int line = 1;
-		int column = 0;
+		// byte classes the word automaton tells apart
+		enum WordClass{
+			WC_OTHER,
+			WC_DIGIT,
+			WC_ALPHA,     // [a-zA-Z_]
+			WC_DOT,
+			WC_BACKSLASH,
+			WC_CR,        // not matched by `.` in the identifier pattern
+			WC_COUNT
+		};
 
-		std::string current_token = "";
-		// if false all whitespace is considered token separators
-		bool catch_whitespace = false;
+		/**
+		 * states of the word automaton, it accepts the same words as
+		 *
+		 *     number:     \d+(\.\d+)?
+		 *     identifier: [a-zA-Z_][a-zA-Z0-9_]*(\\.[a-zA-Z_][a-zA-Z0-9_]*)*
+		 *
+		 */
+		enum WordState{
+			WS_START,
+			WS_NUMBER,
+			WS_NUMBER_DOT,
+			WS_NUMBER_FRACTION,
+			WS_IDENTIFIER,
+			WS_IDENTIFIER_ESCAPE,
+			WS_IDENTIFIER_PART,
+			WS_DEAD,
+			WS_COUNT
+		};
 
+		const WordState WORD_DFA[WS_COUNT][WC_COUNT] = {
+			//                        OTHER                 DIGIT                 ALPHA                 DOT                   BACKSLASH             CR
+			/* WS_START */           {WS_DEAD,              WS_NUMBER,            WS_IDENTIFIER,        WS_DEAD,              WS_DEAD,              WS_DEAD},
+			/* WS_NUMBER */          {WS_DEAD,              WS_NUMBER,            WS_DEAD,              WS_NUMBER_DOT,        WS_DEAD,              WS_DEAD},
+			/* WS_NUMBER_DOT */      {WS_DEAD,              WS_NUMBER_FRACTION,   WS_DEAD,              WS_DEAD,              WS_DEAD,              WS_DEAD},
+			/* WS_NUMBER_FRACTION */ {WS_DEAD,              WS_NUMBER_FRACTION,   WS_DEAD,              WS_DEAD,              WS_DEAD,              WS_DEAD},
+			/* WS_IDENTIFIER */      {WS_DEAD,              WS_IDENTIFIER,        WS_IDENTIFIER,        WS_DEAD,              WS_IDENTIFIER_ESCAPE, WS_DEAD},
+			/* WS_IDENTIFIER_ESCAPE*/{WS_IDENTIFIER_PART,   WS_IDENTIFIER_PART,   WS_IDENTIFIER_PART,   WS_IDENTIFIER_PART,   WS_IDENTIFIER_PART,   WS_DEAD},
+			/* WS_IDENTIFIER_PART */ {WS_DEAD,              WS_DEAD,              WS_IDENTIFIER,        WS_DEAD,              WS_DEAD,              WS_DEAD},
+			/* WS_DEAD */            {WS_DEAD,              WS_DEAD,              WS_DEAD,              WS_DEAD,              WS_DEAD,              WS_DEAD},
+		};
 
-		for (int i = 0; i < code.size(); i++){
-			column++;
-			Token SpecialToken;
-			SpecialToken.type = TOKEN_UNKNOWN;
-			SpecialToken.value = {code[i]};
-			SpecialToken.line = line;
-			for (int j2 = 0; j2 < MCTokens::TCToken_COUNT; j2++)
-			{
-				// check multi char tokens
-				if (code.substr(i, MCTokens::ALL_TCTokens[j2].size()) == MCTokens::ALL_TCTokens[j2])
-				{
-					SpecialToken.type = MCTokens::map[j2];
-					SpecialToken.value = MCTokens::ALL_TCTokens[j2];
-					i += MCTokens::ALL_TCTokens[j2].size() - 1;
+		// token type of a word which ended in a given state
+		const TokenType WORD_ACCEPT[WS_COUNT] = {
+			TOKEN_UNKNOWN,    // WS_START
+			TOKEN_NUMBER,     // WS_NUMBER
+			TOKEN_UNKNOWN,    // WS_NUMBER_DOT
+			TOKEN_NUMBER,     // WS_NUMBER_FRACTION
+			TOKEN_IDENTIFIER, // WS_IDENTIFIER
+			TOKEN_UNKNOWN,    // WS_IDENTIFIER_ESCAPE
+			TOKEN_UNKNOWN,    // WS_IDENTIFIER_PART
+			TOKEN_UNKNOWN,    // WS_DEAD
+		};
+
+		struct CharClass{
+			CharAction action;
+			WordClass word;
+			// type of the single char token, TOKEN_UNKNOWN if there is none
+			TokenType type;
+			// bitmap of the multi char tokens starting with this char
+			int multi;
+		};
+
+		CharClass CLASSES[256];
+
+		// fill in the tables from the token lists above, so those stay the only place to edit
+		bool build(){
+			for (int c = 0; c < 256; c++){
+				CharClass& cls = CLASSES[c];
+				cls.action = CHAR_WORD;
+				cls.type = TOKEN_UNKNOWN;
+				cls.multi = 0;
+				if (c >= '0' and c <= '9')
+					cls.word = WC_DIGIT;
+				else if (c >= 'a' and c <= 'z' or c >= 'A' and c <= 'Z' or c == '_')
+					cls.word = WC_ALPHA;
+				else if (c == '.')
+					cls.word = WC_DOT;
+				else if (c == '\\')
+					cls.word = WC_BACKSLASH;
+				else if (c == '\r')
+					cls.word = WC_CR;
+				else
+					cls.word = WC_OTHER;
+			}
+			CLASSES[' '].action = CHAR_BLANK;
+			CLASSES['\t'].action = CHAR_BLANK;
+			for (int j = 0; j < SCTokens::SCToken_COUNT; j++){
+				CharClass& cls = CLASSES[(unsigned char) SCTokens::ALL_SCTokens[j]];
+				if (cls.type != TOKEN_UNKNOWN)
+					continue; // first entry wins, like the linear scan did
+				cls.action = CHAR_SPECIAL;
+				cls.type = SCTokens::map[j];
+			}
+			for (int j = 0; j < MCTokens::TCToken_COUNT; j++){
+				CharClass& cls = CLASSES[(unsigned char) MCTokens::ALL_TCTokens[j][0]];
+				cls.action = CHAR_SPECIAL;
+				cls.multi |= 1 << j;
+			}
+			return true;
+		}
+
+		bool built = build();
+	}
+
+	/**
+	 * vectorized skipping of byte runs which cannot end a token or change the state of the word automaton,
+	 * the lexer then only looks at the bytes where something actually happens
+	 */
+	namespace Scan{
+		enum Set{
+			SET_BLANK,      // [ \t]
+			SET_DIGIT,      // [0-9]
+			SET_IDENTIFIER, // [a-zA-Z0-9_]
+			SET_TEXT,       // [a-zA-Z0-9_ \t], the common parts of strings
+			SET_COUNT
+		};
+
+		enum Level{
+			LEVEL_NONE,   // the sets disagree with the lexer tables, nothing is skipped
+			LEVEL_SCALAR,
+			LEVEL_SSE2,
+			LEVEL_AVX2,
+		};
+
+		// returns the first byte in [p, end) which is not in the set
+		typedef const char* (*Skipper)(const char* p, const char* end);
+
+		bool member(Set set, unsigned char c){
+			bool blank = c == ' ' or c == '\t';
+			bool digit = c >= '0' and c <= '9';
+			bool identifier = digit or c >= 'a' and c <= 'z' or c >= 'A' and c <= 'Z' or c == '_';
+			switch (set){
+				case SET_BLANK:      return blank;
+				case SET_DIGIT:      return digit;
+				case SET_IDENTIFIER: return identifier;
+				default:             return identifier or blank;
+			}
+		}
+
+		bool MEMBER[SET_COUNT][256];
+
+		const char* skip_none(const char* p, const char* end){
+			return p;
+		}
+
+		template<Set set>
+		const char* skip_scalar(const char* p, const char* end){
+			while (p != end and MEMBER[set][(unsigned char) *p])
+				p++;
+			return p;
+		}
+
+		#ifdef CFUSS_X86_SIMD
+		template<Set set>
+		inline __m128i in_set_sse2(__m128i v){
+			__m128i blank = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+			if constexpr (set == SET_BLANK)
+				return blank;
+			// unsigned range checks, x <= n exactly when min(x, n) == x
+			__m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+			__m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+			if constexpr (set == SET_DIGIT)
+				return digit;
+			__m128i l = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+			__m128i alpha = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(25)), l);
+			__m128i identifier = _mm_or_si128(_mm_or_si128(alpha, digit), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+			if constexpr (set == SET_IDENTIFIER)
+				return identifier;
+			return _mm_or_si128(identifier, blank);
+		}
+
+		template<Set set>
+		const char* skip_sse2(const char* p, const char* end){
+			while (end - p >= 16){
+				__m128i v = _mm_loadu_si128((const __m128i*) p);
+				unsigned outside = ~_mm_movemask_epi8(in_set_sse2<set>(v)) & 0xFFFF;
+				if (outside)
+					return p + __builtin_ctz(outside);
+				p += 16;
+			}
+			return skip_scalar<set>(p, end);
+		}
+
+		template<Set set>
+		__attribute__((target("avx2")))
+		inline __m256i in_set_avx2(__m256i v){
+			__m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+			if constexpr (set == SET_BLANK)
+				return blank;
+			__m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+			__m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+			if constexpr (set == SET_DIGIT)
+				return digit;
+			__m256i l = _mm256_sub_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+			__m256i alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(l, _mm256_set1_epi8(25)), l);
+			__m256i identifier = _mm256_or_si256(_mm256_or_si256(alpha, digit), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+			if constexpr (set == SET_IDENTIFIER)
+				return identifier;
+			return _mm256_or_si256(identifier, blank);
+		}
+
+		template<Set set>
+		__attribute__((target("avx2")))
+		const char* skip_avx2(const char* p, const char* end){
+			while (end - p >= 32){
+				__m256i v = _mm256_loadu_si256((const __m256i*) p);
+				unsigned outside = ~(unsigned) _mm256_movemask_epi8(in_set_avx2<set>(v));
+				if (outside)
+					return p + __builtin_ctz(outside);
+				p += 32;
+			}
+			return skip_sse2<set>(p, end);
+		}
+		#endif
+
+		Skipper SKIP[SET_COUNT];
+		Level level = LEVEL_NONE;
+
+		// the skipped bytes never reach the lexer, so the sets have to agree with its tables
+		bool agrees_with_tables(){
+			using namespace Table;
+			for (int c = 0; c < 256; c++){
+				const CharClass& cls = CLASSES[c];
+				if (MEMBER[SET_BLANK][c] and cls.action != CHAR_BLANK)
+					return false;
+				if (MEMBER[SET_DIGIT][c] and (cls.action != CHAR_WORD or cls.word != WC_DIGIT))
+					return false;
+				if (MEMBER[SET_IDENTIFIER][c] and (cls.action != CHAR_WORD or cls.word != WC_DIGIT and cls.word != WC_ALPHA))
+					return false;
+				if (MEMBER[SET_TEXT][c] and cls.action != CHAR_WORD and cls.action != CHAR_BLANK)
+					return false;
+			}
+			return true;
+		}
+
+		// use the best implementation up to max, which the cpu supports
+		Level select(Level max){
+			for (int set = 0; set < SET_COUNT; set++)
+				for (int c = 0; c < 256; c++)
+					MEMBER[set][c] = member((Set) set, c);
+
+			level = LEVEL_SCALAR;
+			#ifdef CFUSS_X86_SIMD
+			if (max >= LEVEL_SSE2)
+				level = LEVEL_SSE2;
+			if (max >= LEVEL_AVX2 and __builtin_cpu_supports("avx2"))
+				level = LEVEL_AVX2;
+			#endif
+			if (max < level)
+				level = max;
+			if (!agrees_with_tables())
+				level = LEVEL_NONE;
+
+			switch (level){
+				case LEVEL_NONE:
+					for (int set = 0; set < SET_COUNT; set++)
+						SKIP[set] = skip_none;
+					break;
+				case LEVEL_SCALAR:
+					SKIP[SET_BLANK]      = skip_scalar<SET_BLANK>;
+					SKIP[SET_DIGIT]      = skip_scalar<SET_DIGIT>;
+					SKIP[SET_IDENTIFIER] = skip_scalar<SET_IDENTIFIER>;
+					SKIP[SET_TEXT]       = skip_scalar<SET_TEXT>;
+					break;
+				#ifdef CFUSS_X86_SIMD
+				case LEVEL_SSE2:
+					SKIP[SET_BLANK]      = skip_sse2<SET_BLANK>;
+					SKIP[SET_DIGIT]      = skip_sse2<SET_DIGIT>;
+					SKIP[SET_IDENTIFIER] = skip_sse2<SET_IDENTIFIER>;
+					SKIP[SET_TEXT]       = skip_sse2<SET_TEXT>;
+					break;
+				case LEVEL_AVX2:
+					SKIP[SET_BLANK]      = skip_avx2<SET_BLANK>;
+					SKIP[SET_DIGIT]      = skip_avx2<SET_DIGIT>;
+					SKIP[SET_IDENTIFIER] = skip_avx2<SET_IDENTIFIER>;
+					SKIP[SET_TEXT]       = skip_avx2<SET_TEXT>;
+					break;
+				#endif
+				default:
 					break;
-				}
 			}
-			if (SpecialToken.type == TOKEN_UNKNOWN){
-				// check for single char tokens
-				for (int j = 0; j < SCTokens::SCToken_COUNT; j++){
-					if (code[i] == SCTokens::ALL_SCTokens[j]){
-						SpecialToken.type = SCTokens::map[j];
+			return level;
+		}
 
-						break;
-					}
-				}
+		Level selected = select(LEVEL_AVX2);
+
+		// index of the last byte after i, which the word automaton in the given state would not change on
+		inline size_t skip_word(std::string_view code, size_t i, Table::WordState state, bool catch_whitespace){
+			Set set;
+			switch (state){
+				case Table::WS_NUMBER:
+				case Table::WS_NUMBER_FRACTION:
+					set = SET_DIGIT;
+					break;
+				case Table::WS_IDENTIFIER:
+					set = SET_IDENTIFIER;
+					break;
+				case Table::WS_DEAD:
+					// inside strings the words also carry on over whitespace
+					set = catch_whitespace ? SET_TEXT : SET_IDENTIFIER;
+					break;
+				default:
+					return i;
 			}
-			if ((code[i] == ' ' or code[i] == '\t') and not catch_whitespace or SpecialToken.type != TOKEN_UNKNOWN) {
-				if (code[i] == ' ')
-					SpecialToken.debug += "W";
-				else
-					SpecialToken.debug += "S";
-				if (catch_whitespace)
-					SpecialToken.debug += "C";
-				else
-					SpecialToken.debug += " ";
-
-				if (current_token == ""){
-					if (SpecialToken.type != TOKEN_UNKNOWN){
-						SpecialToken.debug += "a";
-						if (!catch_whitespace and (1<<SpecialToken.type & start_ws_ignore)){
-							catch_whitespace = true;
-							SpecialToken.debug += "+";
-						}
-						else if (catch_whitespace and (1<<SpecialToken.type & stop_ws_ignore)){
-							catch_whitespace = false;
-							SpecialToken.debug += "-";
-						}
-						tokens.push_back(SpecialToken);
-						if (SpecialToken.value == "\n"){
-							line++;
-							column = 0;
-						}
-					}
-					continue;
-				}
-				// if the current char is a newline, we will have to add a newline token after
+			return SKIP[set](code.data() + i + 1, code.data() + code.size()) - code.data() - 1;
+		}
+	}
 
-				// check if the current token is valid
-				Token token;
-				token.type  = TOKEN_UNKNOWN;
-				token.value = current_token;
-				token.line  = line;
-				if (code[i] == ' ')
-					token.debug += "W";
-				else
-					token.debug += "S";
-				if (catch_whitespace)
-					token.debug += "C";
-				else
-					token.debug += " ";
+	// classify and add a finished word, returns the new whitespace catching state
+	template<bool Trace>
+	bool add_word(
+		std::string_view code,
+		TokenBuffer& tokens,
+		size_t start,
+		size_t end,
+		Table::WordState state,
+		bool catch_whitespace,
+		unsigned char separator
+	){
+		TokenType type = Table::WORD_ACCEPT[state];
+		unsigned char debug = separator | DEBUG_WORD;
+		if (catch_whitespace)
+			debug |= DEBUG_CATCHING;
 
-				// since comparations are way faster than regexes
-				// check for "keywords" first
+		// the automaton already knows if the word is a number or an identifier
+		// keywords are a subset of identifiers, so only those need looking up
+		if (type == TOKEN_IDENTIFIER){
+			TokenType keyword = Keywords::lookup(code.substr(start, end - start));
+			if (keyword != TOKEN_UNKNOWN)
+				type = keyword;
+		}
 
-				for (int i = 0; i < Keywords::KEYWORD_COUNT; i++){
-					if (current_token == Keywords::ALL_KEYWORDS[i]){
-						token.type = Keywords::map[i];
-						break;
-					}
-				}
+		// check if the added token turns whitespace ignoring on or off
+		if (!catch_whitespace and 1<<type & start_ws_ignore){
+			catch_whitespace = true;
+			debug |= DEBUG_START_WS;
+		}
+		else if (catch_whitespace and 1<<type & stop_ws_ignore){
+			catch_whitespace = false;
+			debug |= DEBUG_STOP_WS;
+		}
 
-				// if not a keyword check for regexes
+		// yes there is a chance that the token is unknown
+		// the parser will have to handle this
+		tokens.push(type, start, end - start);
+		if constexpr (Trace)
+			tokens.debug.push_back(debug);
+		return catch_whitespace;
+	}
 
-				if (token.type == TOKEN_UNKNOWN){
-					for (int j = 0; j < RegexPatterns::PATTERN_COUNT; j++){
-						if (std::regex_match(current_token, RegexPatterns::ALL_PATTERNS[j])){
-							token.type = RegexPatterns::map[j];
-							break;
-						}
-					}
-				}
+	// lex code from begin on, adding the tokens and the starts of the lines after each newline
+	// returns whether whitespace is being caught at the end
+	// the debug flags are only worked out and stored when tracing
+	template<bool Trace>
+	bool tokenize_range(std::string_view code, size_t begin, bool catch_whitespace, TokenBuffer& tokens){
+		using namespace Table;
 
-				token.debug += "b";
-				// check if the added token turns whitespace ignoring on or off
-				if (!catch_whitespace and 1<<token.type & start_ws_ignore){
-					catch_whitespace = true;
-					token.debug += "+";
-				}
-				else if (catch_whitespace and 1<<token.type & stop_ws_ignore){
-					catch_whitespace = false;
-					token.debug += "-";
-				}
+		// start and automaton state of the word being read, NO_WORD if there is none
+		const size_t NO_WORD = std::string_view::npos;
+		size_t word_start = NO_WORD;
+		WordState word_state = WS_START;
 
-				// Add the token to the vector
-				tokens.push_back(token);
+		const size_t size = code.size();
+		for (size_t i = begin; i < size; i++){
+			// every byte is classified exactly once
+			const CharClass& cls = CLASSES[(unsigned char) code[i]];
 
-				// if the charachter is a newline, add a newline token
-				if (SpecialToken.type != TOKEN_UNKNOWN){
-					SpecialToken.debug += "c";
-					// check if the newline token turns whitespace ignoring on or off
-					// (it most likely will turn off, but for the sake of not hardcoding it)
-					if (!catch_whitespace and 1<<SpecialToken.type & start_ws_ignore){
-						catch_whitespace = true;
-						SpecialToken.debug += "+";
-					}
-					else if (catch_whitespace and 1<<SpecialToken.type & stop_ws_ignore){
-						catch_whitespace = false;
-						SpecialToken.debug += "-";
-					}
-					if (SpecialToken.value == "\n"){
-						line++;
-						column = 0;
+			TokenType special = TOKEN_UNKNOWN;
+			size_t special_start = i;
+			if (cls.action == CHAR_SPECIAL){
+				// check multi char tokens, they take precedence
+				for (int j = 0; cls.multi >> j; j++){
+					if (
+						    cls.multi >> j & 1
+						and code.compare(i, MCTokens::ALL_TCTokens[j].size(), MCTokens::ALL_TCTokens[j]) == 0
+					){
+						special = MCTokens::map[j];
+						i += MCTokens::ALL_TCTokens[j].size() - 1;
+						break;
 					}
-					tokens.push_back(SpecialToken);
 				}
+				if (special == TOKEN_UNKNOWN)
+					special = cls.type;
+			}
+
+			if (special == TOKEN_UNKNOWN and (cls.action != CHAR_BLANK or catch_whitespace)){
+				// the char is a part of a word
+				if (word_start == NO_WORD){
+					word_start = i;
+					word_state = WS_START;
+				}
+				word_state = WORD_DFA[word_state][cls.word];
+				i = Scan::skip_word(code, i, word_state, catch_whitespace);
+				continue;
+			}
 
-				// yes there is a chance that the current token is unknown
-				// the parser will have to handle this
+			// the special token is flagged with the state from before the word
+			unsigned char separator = code[i] == ' ' ? 0 : DEBUG_NOT_SPACE;
+			unsigned char special_debug = separator | (catch_whitespace ? DEBUG_CATCHING : 0);
 
-				// reset the current token
-				current_token = "";
+			if (word_start != NO_WORD){
+				catch_whitespace = add_word<Trace>(code, tokens, word_start, special_start, word_state, catch_whitespace, separator);
+				word_start = NO_WORD;
+				special_debug |= DEBUG_AFTER;
+			}
 
+			if (special == TOKEN_UNKNOWN){
+				// a blank outside of strings, the ones following it do nothing either
+				i = Scan::SKIP[Scan::SET_BLANK](code.data() + i + 1, code.data() + size) - code.data() - 1;
 				continue;
 			}
 
-			// if all the above checks fail, add the char to the current token
-			current_token += code[i];
+			// check if the special token turns whitespace ignoring on or off
+			if (!catch_whitespace and 1<<special & start_ws_ignore){
+				catch_whitespace = true;
+				special_debug |= DEBUG_START_WS;
+			}
+			else if (catch_whitespace and 1<<special & stop_ws_ignore){
+				catch_whitespace = false;
+				special_debug |= DEBUG_STOP_WS;
+			}
+			tokens.push(special, special_start, i + 1 - special_start);
+			if constexpr (Trace)
+				tokens.debug.push_back(special_debug);
+
+			if (special == TOKEN_NEWLINE)
+				tokens.lines.starts.push_back(i + 1);
 		}
 
+		// a word running into the end of the input is ended like by a trailing space,
+		// unless whitespace is being caught, then it would never have been ended
+		if (word_start != NO_WORD and not catch_whitespace)
+			catch_whitespace = add_word<Trace>(code, tokens, word_start, size, word_state, catch_whitespace, 0);
 
-		return tokens;
+		return catch_whitespace;
 	}
 
-}
+	namespace Parallel{
+		// below this the threads cost more than they save
+		const int MIN_SIZE = 1 << 20;
+		// chunks per thread, so a slow chunk does not hold up everyone else
+		const int CHUNKS_PER_THREAD = 4;
 
-namespace Parser{
-	enum _ValType{
-		TYPE_VOID,
+		// a chunk can only start after a newline, if no multi char token could span it
+		bool can_split(){
+			for (int j = 0; j < MCTokens::TCToken_COUNT; j++)
+				if (MCTokens::ALL_TCTokens[j].find('\n') != std::string::npos)
+					return false;
+			return true;
+		}
+
+		// if newlines always end whitespace catching, every chunk starts in the same state
+		const bool NEWLINE_RESETS =
+			    (stop_ws_ignore >> TOKEN_NEWLINE & 1)
+			and not (start_ws_ignore >> TOKEN_NEWLINE & 1);
+
+		struct Chunk{
+			size_t begin;
+			size_t end;
+			// results for starting without and with whitespace catching
+			TokenBuffer tokens[2];
+			bool catching_after[2];
+			// which of the results is the right one
+			int pick;
+		};
+
+		template<typename T>
+		void copy(std::vector<T>& to, size_t at, const std::vector<T>& from){
+			if (!from.empty())
+				std::memcpy(to.data() + at, from.data(), from.size() * sizeof(T));
+		}
+
+		/**
+		 * lex the chunks on the thread pool, for both states whitespace catching could be in at their start,
+		 * unless the chunk follows a newline which settles it, and stitch the results that turned out right
+		 */
+		template<bool Trace>
+		TokenBuffer tokenize(std::string_view code, Threads::Pool& pool){
+			std::vector<Chunk> chunks;
+			int count = pool.size() * CHUNKS_PER_THREAD;
+			size_t begin = 0;
+			for (int k = 1; k <= count and begin < code.size(); k++){
+				size_t end = code.size();
+				if (k < count){
+					size_t newline = code.find('\n', std::max(begin, code.size() * k / count));
+					if (newline != std::string_view::npos)
+						end = newline + 1;
+				}
+				chunks.push_back({begin, end});
+				begin = end;
+			}
+
+			pool.run(chunks.size() * 2, [&](int task){
+				Chunk& chunk = chunks[task / 2];
+				bool catching = task % 2;
+				if (catching and (NEWLINE_RESETS or chunk.begin == 0))
+					return;
+				chunk.tokens[catching].reserve(expected_tokens(chunk.end - chunk.begin), Trace);
+				chunk.catching_after[catching] = tokenize_range<Trace>(
+					code.substr(0, chunk.end), chunk.begin, catching, chunk.tokens[catching]
+				);
+			});
+
+			// follow the state from chunk to chunk to pick the right results
+			// line starts are offsets into the whole buffer, so they need no fixing up
+			std::vector<size_t> starts(chunks.size() + 1, 0);
+			std::vector<size_t> line_starts(chunks.size() + 1, 1);
+			bool catching = false;
+			for (int k = 0; k < chunks.size(); k++){
+				Chunk& chunk = chunks[k];
+				chunk.pick = catching;
+				catching = chunk.catching_after[chunk.pick];
+				starts[k+1] = starts[k] + chunk.tokens[chunk.pick].size();
+				line_starts[k+1] = line_starts[k] + chunk.tokens[chunk.pick].lines.starts.size();
+			}
+
+			TokenBuffer tokens;
+			tokens.code = code;
+			tokens.types.resize(starts.back());
+			tokens.offsets.resize(starts.back());
+			tokens.lengths.resize(starts.back());
+			if constexpr (Trace)
+				tokens.debug.resize(starts.back());
+			tokens.lines.code = code;
+			tokens.lines.starts.resize(line_starts.back());
+			tokens.lines.starts[0] = 0;
+			pool.run(chunks.size(), [&](int k){
+				const TokenBuffer& picked = chunks[k].tokens[chunks[k].pick];
+				copy(tokens.types, starts[k], picked.types);
+				copy(tokens.offsets, starts[k], picked.offsets);
+				copy(tokens.lengths, starts[k], picked.lengths);
+				copy(tokens.debug, starts[k], picked.debug);
+				copy(tokens.lines.starts, line_starts[k], picked.lines.starts);
+				// the chunk is not needed anymore, give its memory back before the parser wants some
+				chunks[k].tokens[0] = TokenBuffer();
+				chunks[k].tokens[1] = TokenBuffer();
+			});
+			return tokens;
+		}
+	}
+
+	/**
+	 * pairs up brackets, square brackets, quotes and multiline string delimiters with one scan and a stack
+	 *
+	 * strings follow the same rules as in the parser, what is inside of them is text,
+	 * round brackets do not reach past the end of their line,
+	 * and a closing square bracket also closes the round ones still open after its partner
+	 *
+	 * a multiline string which is never closed points at the token it breaks off at instead (or at end),
+	 * without being pointed back at
+	 *
+	 * only the tokens in [begin, end) are paired, as if nothing came before or after them,
+	 * their partners have to be NO_PARTNER beforehand
+	 */
+	void match_pairs(TokenBuffer& tokens, uint32_t begin, uint32_t end){
+		std::vector<uint32_t>& partners = tokens.partners;
+		const std::vector<uint8_t>& types = tokens.types;
+		// open brackets, round ones are only ever on top of square ones
+		std::vector<uint32_t> open;
+
+		auto pair = [&](uint32_t a, uint32_t b){
+			partners[a] = b;
+			partners[b] = a;
+		};
+		auto close_line = [&](){
+			while (not open.empty() and types[open.back()] == TOKEN_BRACKET_O)
+				open.pop_back();
+		};
+		// where the parser picks up again after a broken string, the end of the line it broke on
+		auto line_end = [&](uint32_t i){
+			while (i < end and types[i] != TOKEN_NEWLINE)
+				i++;
+			return i;
+		};
+
+		uint32_t i = begin;
+		while (i < end){
+			switch (types[i]){
+				case TOKEN_QUOTE:
+					{
+						uint32_t j = i + 1;
+						while (j < end and types[j] != TOKEN_QUOTE and types[j] != TOKEN_NEWLINE)
+							j++;
+						if (j < end and types[j] == TOKEN_QUOTE){
+							pair(i, j);
+							i = j + 1;
+						}
+						else
+							i = j;
+					}
+					continue;
+				case TOKEN_MULTILINE_STRING_START:
+					{
+						uint32_t j = i + 1;
+						if (j < end and types[j] == TOKEN_NEWLINE)
+							j++;
+						// every line after the first has to start with a quote
+						bool in_string = true;
+						for (; j < end and types[j] != TOKEN_MULTILINE_STRING_END; j++){
+							if (in_string)
+								in_string = types[j] != TOKEN_NEWLINE;
+							else if (types[j] != TOKEN_QUOTE)
+								break;
+							else
+								in_string = true;
+						}
+						if (j < end and types[j] == TOKEN_MULTILINE_STRING_END){
+							pair(i, j);
+							i = j + 1;
+							continue;
+						}
+						// a line without its quote, the string still ends at the next end, unless another one starts first
+						uint32_t k = j;
+						while (k < end and types[k] != TOKEN_MULTILINE_STRING_END and types[k] != TOKEN_MULTILINE_STRING_START)
+							k++;
+						if (k < end and types[k] == TOKEN_MULTILINE_STRING_END){
+							pair(i, k);
+							i = line_end(k);
+						}
+						else{
+							partners[i] = j;
+							i = line_end(j);
+						}
+					}
+					continue;
+				case TOKEN_BRACKET_O:
+				case TOKEN_SQ_BRACKET_O:
+					open.push_back(i);
+					break;
+				case TOKEN_BRACKET_C:
+					if (not open.empty() and types[open.back()] == TOKEN_BRACKET_O){
+						pair(open.back(), i);
+						open.pop_back();
+					}
+					break;
+				case TOKEN_SQ_BRACKET_C:
+					close_line();
+					if (not open.empty()){
+						pair(open.back(), i);
+						open.pop_back();
+					}
+					break;
+				case TOKEN_NEWLINE:
+					close_line();
+					break;
+				default:
+					break;
+			}
+			i++;
+		}
+	}
+
+	template<bool Trace>
+	TokenBuffer tokenize(std::string_view code){
+		TokenBuffer tokens;
+		if (code.size() >= Parallel::MIN_SIZE and Threads::cores() > 1 and Parallel::can_split())
+			tokens = Parallel::tokenize<Trace>(code, Threads::pool());
+		else{
+			tokens.code = code;
+			tokens.reserve(expected_tokens(code.size()), Trace);
+			tokens.lines.code = code;
+			tokens.lines.starts.push_back(0);
+			tokenize_range<Trace>(code, 0, false, tokens);
+		}
+
+		// identifiers are interned once all chunks are done, the table is not shared between threads
+		Symbols::Interner& table = Symbols::table();
+		tokens.symbols.assign(tokens.size(), Symbols::NONE);
+		for (size_t i = 0; i < tokens.size(); i++)
+			if (tokens.types[i] == TOKEN_IDENTIFIER)
+				tokens.symbols[i] = table.intern(tokens.value(i));
+		tokens.partners.assign(tokens.size(), NO_PARTNER);
+		match_pairs(tokens, 0, tokens.size());
+		return tokens;
+	}
+
+	/**
+	 * the returned tokens point into code, so it has to stay alive for as long as they are used,
+	 * code can not be longer than MAX_SIZE, main turns longer inputs away
+	 *
+	 * with trace the debug flags of every token are kept as well, otherwise they are compiled out
+	 */
+	TokenBuffer tokenize(std::string_view code, bool trace = false){
+		if (trace)
+			return tokenize<true>(code);
+		return tokenize<false>(code);
+	}
+
+}
+
+namespace Parser{
+	enum _ValType{
+		TYPE_VOID,
 		TYPE_NUM,
 		TYPE_STR,
 	};
 
-	union ValType{
+	struct ValType{
 		bool is_struct;
 		_ValType type;
-		std::string* struct_name;
+		// only set for structures
+		Symbols::Symbol struct_name;
 		ValType(_ValType type){
 			is_struct = false;
 			this->type = type;
 		}
-		ValType(std::string name){
+		ValType(std::string_view name){
 			if (name == "void"){
 				is_struct = false;
 				type = (TYPE_VOID);
@@ -425,13 +1488,37 @@ namespace Parser{
 			}
 			else if (name == "structure"){
 				is_struct = true;
-				struct_name = new std::string("UKNOWN");
+				struct_name = Symbols::table().intern("UKNOWN");
 			}
 			else{
 				is_struct = true;
-				struct_name = new std::string(name);
+				struct_name = Symbols::table().intern(name);
 			}
 		}
+
+		// a type in one word, structures are their name with the top bit set
+		uint32_t packed() const{
+			return is_struct ? struct_name | STRUCT_BIT : type;
+		}
+
+		// as it is written in the source
+		std::string_view name() const{
+			if (is_struct)
+				return Symbols::table().name(struct_name);
+			static const std::string_view names[] = {"void", "num", "str"};
+			return names[type];
+		}
+
+		static ValType unpack(uint32_t packed){
+			if (not (packed & STRUCT_BIT))
+				return ValType((_ValType) packed);
+			ValType type(TYPE_VOID);
+			type.is_struct = true;
+			type.struct_name = packed & ~STRUCT_BIT;
+			return type;
+		}
+
+		static const uint32_t STRUCT_BIT = 1u << 31;
 	};
 
 	enum ElementType{
@@ -450,64 +1537,176 @@ namespace Parser{
 		ELEMENT_SERVE,
 	};
 
-	struct Element{
-		ElementType type;
+	typedef uint32_t NodeId;
+
+	// node 0 is a void node, children which are not there point at it
+	const NodeId NO_NODE = 0;
+
+	enum NodeFlags{
+		FLAG_IN_SOURCE = 1 << 0, // the text of a string literal is in the source, not in Tree::strings
+	};
+
+	/**
+	 * node of the flat syntax tree, nodes refer to their children by index and come after them
+	 *
+	 * lists are stored in Tree::extra as their length followed by the items, what aux, a and b hold depends on the type:
+	 *
+	 *     ELEMENT_OPERATION      aux: operator   a: left or NO_NODE            b: right or NO_NODE
+	 *     ELEMENT_LITERAL        aux: _ValType   a: start of text              b: length of text
+	 *                                            a, b: low and high half of the bits of a num, see Tree::number
+	 *     ELEMENT_REF                            a: symbol
+	 *     ELEMENT_FUNCTION_CALL                  a: symbol                     b: list of arguments
+	 *     ELEMENT_SERVE                          a: value or NO_NODE
+	 *     ELEMENT_MACRO_DEF                      a: symbol                     b: type, body
+	 *     ELEMENT_FUNCTION_DEF                   a: symbol                     b: return type, list of the body, list of
+	 *                                                                             parameters (name, type, default or NO_NODE)
+	 */
+	struct Node{
+		uint8_t type;
+		uint8_t aux;
+		uint8_t flags;
 		int line;
-		std::string value;
-		std::string debug;
-		union Data{
-			int void_;
-			Lexer::Token* token;
-			struct Operation{
-				Element* l;
-				Element* r;
-				char op;
-			} operation;
-			struct Literal{
-				_ValType type;
-				union Value{
-					int num;
-					std::string * str;
-				} value;
-			} literal;
-			struct MacroDef{
-				std::string* name;
-				Element* body;
-				ValType type;
-			} macro_def;
-			struct FuncDef{
-				std::string* name;
-				std::vector<std::string> *args;
-				std::vector<ValType> *argTypes;
-				std::vector<Element> *argDefaults; // void = no default
-				std::vector<Element> *body;
-				ValType ret_type;
-			} function_def;
-			struct FuncCall{
-				std::string* name;
-				std::vector<Element> *args;
-			} function_call;
-			std::string* ref;
-			struct Serve{
-				std::string* name;
-				std::vector<Element> *args;
-			} serve;
-		} data;
+		// the source text the node was made from
+		uint32_t offset;
+		uint32_t length;
+		uint32_t a;
+		uint32_t b;
+	};
+
+	// the parts of a function declaration, as they are laid out in Tree::extra
+	struct Function{
+		ValType ret_type;
+		Memory::List<const NodeId> body;
+		uint32_t parameter_count;
+		const uint32_t* parameters;
+
+		Symbols::Symbol name(uint32_t i) const{
+			return parameters[i*3];
+		}
+
+		ValType type(uint32_t i) const{
+			return ValType::unpack(parameters[i*3 + 1]);
+		}
+
+		// NO_NODE if the parameter has no default
+		NodeId fallback(uint32_t i) const{
+			return parameters[i*3 + 2];
+		}
+	};
+
+	struct Tree{
+		std::string_view code;
+		std::vector<Node> nodes;
+		std::vector<uint32_t> extra;
+		// text of the string literals which are not in the source as they are
+		std::string strings;
+		// index of the list of top level statements in extra
+		uint32_t top;
+
+		const Node& operator[](NodeId id) const{
+			return nodes[id];
+		}
+
+		std::string_view value(NodeId id) const{
+			return code.substr(nodes[id].offset, nodes[id].length);
+		}
+
+		Memory::List<const uint32_t> list(uint32_t at) const{
+			return {extra.data() + at + 1, extra[at]};
+		}
+
+		Memory::List<const NodeId> statements() const{
+			return list(top);
+		}
+
+		// the value of a num literal
+		double number(NodeId id) const{
+			uint64_t bits = (uint64_t) nodes[id].b << 32 | nodes[id].a;
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		// the contents of a string literal
+		std::string_view text(NodeId id) const{
+			const Node& node = nodes[id];
+			if (node.flags & FLAG_IN_SOURCE)
+				return code.substr(node.a, node.b);
+			return std::string_view(strings).substr(node.a, node.b);
+		}
+
+		ValType macro_type(NodeId id) const{
+			return ValType::unpack(extra[nodes[id].b]);
+		}
+
+		NodeId macro_body(NodeId id) const{
+			return extra[nodes[id].b + 1];
+		}
+
+		Function function(NodeId id) const{
+			const uint32_t* at = extra.data() + nodes[id].b;
+			return {ValType::unpack(at[0]), list(at[1]), at[2], at + 3};
+		}
 	};
 
 	struct ParserError{
 		int line;
-		std::string message;
-		ParserError *previous;
+		std::string_view message;
+		// the source text the error is about, used to point at the column
+		std::string_view at;
+	};
+
+	/**
+	 * the errors of a parse, they and their messages live in an arena of their own
+	 *
+	 * only the first error on a line is kept, the rest on it usually follow from that one,
+	 * and once the limit is reached nothing more is, see full
+	 */
+	class Diagnostics{
+		public:
+			// 0 for no limit
+			Diagnostics(uint32_t limit = 0) : limit(limit){}
+
+			void add(int line, std::string_view message, std::string_view at){
+				if (full() or (errors.count > 0 and line == errors[errors.count-1].line))
+					return;
+				if (errors.count == capacity){
+					// the old items stay behind in the arena, at most as many as there are now
+					capacity = capacity == 0 ? 16 : capacity * 2;
+					ParserError* items = (ParserError*) arena.allocate(sizeof(ParserError) * capacity, alignof(ParserError));
+					std::uninitialized_copy(errors.begin(), errors.end(), items);
+					errors.items = items;
+				}
+				errors.items[errors.count++] = {line, arena.copy(message), at};
+			}
+
+			// if the limit of errors was reached, parsing stops there
+			bool full() const{
+				return limit != 0 and errors.count >= limit;
+			}
+
+			bool empty() const{
+				return errors.count == 0;
+			}
+
+			Memory::List<const ParserError> list() const{
+				return {errors.items, errors.count};
+			}
+
+		private:
+			Memory::Arena arena;
+			Memory::List<ParserError> errors{nullptr, 0};
+			uint32_t capacity = 0;
+			uint32_t limit;
 	};
 
 	struct ParseResult{
-		std::vector<Element> elements;
-		std::vector<ParserError> errors;
+		Tree tree;
+		Diagnostics errors;
 		bool successful;
 	};
 
-	ValType get_type(std::string type){
+	ValType get_type(std::string_view type){
 		if (type == "void"){
 			return ValType(TYPE_VOID);
 		}
@@ -522,760 +1721,3372 @@ namespace Parser{
 		}
 	}
 
-	ParseResult _parse(std::vector<Element> elements){
-		std::vector<ParserError> errors;
-		bool successful = true;
-
-		bool did_something;
-		do{
-			did_something = false;
-			for (int i = 0; i < elements.size(); i++)
-			{
-				if (elements[i].type == ELEMENT_TOKEN){
-					switch (elements[i].data.token->type){
-						// create number literals out of tokens
-						case Lexer::TOKEN_NUMBER:
-							{
-								Element element = {ELEMENT_LITERAL, elements[i].line, elements[i].value, "L", 0};
-								element.data.literal.type = _ValType::TYPE_NUM;
-								element.data.literal.value.num = std::stoi(elements[i].data.token->value);
-								elements[i] = element;
-								did_something = true;
-							}
-							break;
-						// create null literals out of tokens
-						case Lexer::TOKEN_NULL:
-							{
-								Element element = {ELEMENT_LITERAL, elements[i].line, elements[i].value, "L", 0};
-								element.data.literal.type = _ValType::TYPE_VOID;
-								elements[i] = element;
-								did_something = true;
-							}
-							break;
-						// try creating strings out of tokens
-						/**
-						 * strings are more complicated as they are not just a one token
-						 * single line strings have:
-						 *
-						 *     TOKEN_QUOTE <random token(s)> TOKEN_QUOTE
-						 *
-						 * which is relatively simple
-						 *
-						 * multi line strings have:
-						 *
-						 *     TOKEN_MULTILINE_STRING_START <random token(s) (optional)> TOKEN_NEWLINE
-						 *     TOKEN_QUOTE <random token(s)> TOKEN_NEWLINE
-						 *     TOKEN_MULTILINE_STRING_END
-						 *
-						 */
-
-						// single line string
-						case Lexer::TOKEN_QUOTE:
-							{
-								Element element = {ELEMENT_LITERAL, elements[i].line, "", "L", 0};
-								std::string value = "";
-								// lookahead for the end of the string
-								int j = i+1;
-								for (
-									;
-									elements[j].type == ELEMENT_TOKEN and (
-										elements[j].data.token->type != Lexer::TOKEN_QUOTE and
-										elements[j].data.token->type != Lexer::TOKEN_NEWLINE
-									);
-									j++
-								)
-									value += elements[j].data.token->value;
-
-								if (elements[j].data.token->type != Lexer::TOKEN_QUOTE){
-									// if it is not create an error
-									ParserError error = {elements[i].line, "Expected closing quote"};
-									errors.push_back(error);
-									successful = false;
-									// remove the quote token and the token which would be the content of the string
-									elements.erase(elements.begin()+i, elements.begin()+j+1);
-									did_something = true;
-								}
-								else{
-									element.data.literal.type = _ValType::TYPE_STR;
-									element.data.literal.value.str = &value;
-									element.value = elements[i].value + value + elements[j].value;
-									did_something = true;
-									elements[i] = element;
-									elements.erase(elements.begin()+i+1, elements.begin()+j+1);
-								}
-							}
-							break;
+	struct TraceEntry{
+		int line;
+		std::string message;
+	};
 
-						// multi line string
-						case Lexer::TOKEN_MULTILINE_STRING_START:
-							{
-								Element element = {ELEMENT_LITERAL, elements[i].line, "", "L", 0};
-								std::string value = "";
-								// lookahead for the end of the string
-								int j = i+1;
-								if (elements[j].type == ELEMENT_TOKEN and elements[j].data.token->type == Lexer::TOKEN_NEWLINE)
-									j++;
-
-								bool in_string = true;
-								for(
-									;
-									elements[j].type == ELEMENT_TOKEN and (
-										elements[j].data.token->type != Lexer::TOKEN_MULTILINE_STRING_END
-									);
-									j++
-								){
-									if(in_string)
-									{
-										if(elements[j].data.token->type == Lexer::TOKEN_NEWLINE){
-											value += "\n";
-											in_string = false;
-										}
-										else{
-											value += elements[j].data.token->value;
-										}
-									}
-									else{
-										if (elements[j].data.token->type != Lexer::TOKEN_QUOTE)
-											// error will be created after that
-											break;
-										in_string = true;
-									}
-								}
-								// check why the loop ended
-								if (elements[j].type != ELEMENT_TOKEN or elements[j].data.token->type != Lexer::TOKEN_MULTILINE_STRING_END)
-								{
-									// error
-									// lookahead to see if there is a closing quote
-									int k = j+1;
-									for (
-										;
-										k < elements.size();
-										k++
-									)
-										if (elements[k].type == ELEMENT_TOKEN and elements[k].data.token->type == Lexer::TOKEN_MULTILINE_STRING_END
-										                                       or elements[k].data.token->type == Lexer::TOKEN_MULTILINE_STRING_START)
-											break;
-									if (k == elements.size() or elements[k].data.token->type != Lexer::TOKEN_MULTILINE_STRING_END)
-									{
-										ParserError error = {elements[j].line, "Expected closing multiline string"};
-										errors.push_back(error);
-										successful = false;
-										// remove the quote token and the token which would be the content of the string
-										elements.erase(elements.begin()+i+1, elements.begin()+j+1);
-										Element error_element = {ELEMENT_ERROR, elements[j].line, "<ERROR>", "", 0};
-										elements[i] = error_element;
-									}
-									else{
-										ParserError error = {elements[j].line, "Multiline string continuation missing"};
-										errors.push_back(error);
-										successful = false;
-										// remove the quote token and the token which would be the content of the string
-										elements.erase(elements.begin()+i+1, elements.begin()+k+1);
-										// place an error element
-										Element error_element = {ELEMENT_ERROR, elements[j].line, "<ERROR>", "", 0};
-										elements[i] = error_element;
-									}
-								}
-								else{
-									element.data.literal.type = _ValType::TYPE_STR;
-									element.data.literal.value.str = &value;
-									element.value = elements[i].value + value + elements[j].value;
-									did_something = true;
-									elements[i] = element;
-									elements.erase(elements.begin()+i+1, elements.begin()+j+1);
-								}
-							}
-							break;
-						// error
-						case Lexer::TOKEN_MULTILINE_STRING_END:
-							{
-								ParserError error = {elements[i].line, "Unexpected closing multiline string"};
-								errors.push_back(error);
-								successful = false;
-								// remove the quote token
-								elements.erase(elements.begin()+i);
-							}
-							break;
-						case Lexer::TOKEN_OPERATOR:
-							{
-								if(elements[i].data.token->value != "~"){
-									// check if all the operands cannot be expressions
-									if (i == 0){
-										// error
-										ParserError error = {elements[i].line, "Unexpected operator"};
-										errors.push_back(error);
-										elements.erase(elements.begin()+i);
-										successful = false;
-										break;
-									}
-									if (elements[i-1].type == ELEMENT_TOKEN){
-										if (elements[i-1].data.token->type == Lexer::TOKEN_NEWLINE){
-											// error
-											ParserError error = {elements[i].line, "Unexpected operator (expected operand before operator)"};
-											if (elements[i].data.token->value == "-"){
-												error.message += " (did you mean to use `~`?)";
-											}
-											errors.push_back(error);
-											// remove the token
-											elements.erase(elements.begin()+i);
-											successful = false;
-											break;
-										}
-										if (elements[i-1].data.token->type == Lexer::TOKEN_OPERATOR and elements[i-1].data.token->value != "@"){
-											// error
-											ParserError error = {elements[i].line, "Unexpected operator"};
-											error.message += " (" + elements[i-1].data.token->value + ")";
-											errors.push_back(error);
-											// remove the token
-											elements.erase(elements.begin()+i+1);
-											successful = false;
-											break;
-										}
-									}
-									// check if it is not an expression yet
-									if (
-										    elements[i-1].type != ELEMENT_LITERAL
-										and elements[i-1].type != ELEMENT_FUNCTION_CALL
-										and elements[i-1].type != ELEMENT_REF
-										and elements[i-1].type != ELEMENT_OPERATION
-									){
-										// this operator is not yet ready to be resolved, we will return here later
-										elements[i].debug = "op l ";
-										int a = elements[i-1].type;
-										while (a){
-											elements[i].debug += '0'+a%10;
-											a /= 10;
-										}
-										break;
-									}
-								}
-								if(elements[i].data.token->value != "@"){
-									// check if all the operands cannot be expressions
-									if (i == elements.size()-1){
-										// error
-										ParserError error = {elements[i].line, "EOF while looking for operands"};
-										errors.push_back(error);
-										elements.erase(elements.begin()+i);
-										successful = false;
-										break;
-									}
-									if (elements[i+1].type == ELEMENT_TOKEN){
-										if (elements[i+1].data.token->type == Lexer::TOKEN_NEWLINE){
-											// error
-											ParserError error = {elements[i].line, "Unexpected operator (expected operand after operator)"};
-											errors.push_back(error);
-											elements.erase(elements.begin()+i);
-											successful = false;
-											break;
-										}
-										if (elements[i+1].data.token->type == Lexer::TOKEN_OPERATOR and elements[i+1].data.token->value != "~"){
-											// error
-											ParserError error = {elements[i].line, "Unexpected operator"};
-											error.message += " (" + elements[i-1].data.token->value + ")";
-											if (elements[i+1].data.token->value == "-"){
-												error.message += " (did you mean to use `~`?)";
-											}
-											errors.push_back(error);
-											elements.erase(elements.begin()+i+1);
-											successful = false;
-											break;
-										}
-									}
-									// check if it is not an expression yet
-									if (
-										    elements[i+1].type != ELEMENT_LITERAL
-										and elements[i+1].type != ELEMENT_FUNCTION_CALL
-										and elements[i+1].type != ELEMENT_REF
-										and elements[i+1].type != ELEMENT_OPERATION
-									){
-										// this operator is not yet ready to be resolved, we will return here later
-										elements[i].debug = "op r ";
-										int a = elements[i+1].type;
-										while (a){
-											elements[i].debug += '0'+a%10;
-											a /= 10;
-										}
-										break;
-									}
-								}
-								// construct the new element
-								Element element = {ELEMENT_OPERATION, elements[i].line, elements[i].data.token->value, ""};
-								element.data.operation = {0,0,elements[i].data.token->value[0]};
-								if (elements[i].data.token->value != "~"){
-									element.data.operation.l = &elements[i-1];
-									element.value = elements[i-1].value + element.value;
-									elements.erase(elements.begin()+i-1);
-									i--; // since we removed an element before this one we need to decrement the index
-								}
-								if (elements[i].data.token->value != "@"){
-									element.data.operation.r = &elements[i+1];
-									element.value += elements[i+1].value;
-									elements.erase(elements.begin()+i+1);
-								}
-								// replace the tokens with the new element
-								elements[i] = element;
-								did_something = true;
-							}
-							break;
-						case Lexer::TOKEN_IDENTIFIER:
-							{
-								// check if it is a function call
-								if(elements[i+1].type == ELEMENT_TOKEN and elements[i+1].data.token->type == Lexer::TOKEN_BRACKET_O){
-									// look for the matching bracket
-									int bracket_c = i+2;
-									for (;bracket_c != elements.size(); bracket_c++)
-									{
-										if (elements[bracket_c].type == ELEMENT_TOKEN and elements[bracket_c].data.token->type == Lexer::TOKEN_BRACKET_C){
-											break;
-										}
-									}
-									if (bracket_c == elements.size()){
-										// error
-										ParserError error = {elements[i].line, "Missing closing bracket"};
-										errors.push_back(error);
-										successful = false;
-										break;
-									}
-									// construct the new element
-									Element element = {ELEMENT_FUNCTION_CALL, elements[i].line, elements[i].data.token->value, ""};
-									element.data.function_call = {};
-									element.data.function_call.name = &elements[i].data.token->value;
-									element.data.function_call.args = new std::vector<Element>();
-									bool can_add_new_arg = true;
-									bool complete = false;
-									bool a_error = false;
-									for (int j = i+2; j < bracket_c; j++)
-									{
-										if (can_add_new_arg){
-											if (elements[j].type == ELEMENT_TOKEN and elements[j].data.token->type == Lexer::TOKEN_COMMA){
-												// syntax error
-												ParserError error = {elements[i].line, "Unexpected comma, expected expression"};
-												errors.push_back(error);
-												successful = false;
-												a_error = true;
-												break;
-											}
-											element.data.function_call.args->push_back(elements[j]);
-											can_add_new_arg = false;
-										}
-										else if (elements[j].type == ELEMENT_TOKEN and elements[j].data.token->type == Lexer::TOKEN_COMMA){
-											can_add_new_arg = true;
-										}
-										else{
-											// we must not be ready
-										}
-									}
-									if (a_error){
-										// clean up, remove the function call
-										for (int j = i+1; j <= bracket_c; j++)
-										{
-											elements.erase(elements.begin()+i);
-										}
-										Element error_element = {ELEMENT_ERROR, elements[i].line, "<ERROR>", "", 0};
-										elements[i] = error_element;
-										break;
-									}
-
-									// replace the tokens with the new element
-									for (int j = i+1; j <= bracket_c; j++)
-									{
-										elements.erase(elements.begin()+i);
-									}
-									elements[i] = element;
-									did_something = true;
-									break;
-								}
-								// it is a refernce
+	// what the parser did along the way, only filled in when tracing
+	std::vector<TraceEntry> trace_log;
 
-								Element element = {ELEMENT_REF, elements[i].line, elements[i].data.token->value, ""};
-								element.data.ref = &elements[i].data.token->value;
-								elements[i] = element;
-								did_something = true;
-								break;
-							}
-							break;
+	namespace Operators{
+		const char PREFIX = '~';
+		const char POSTFIX = '@';
 
-						case Lexer::TOKEN_KEYWORD:
-							{
-								if (elements[i].value == "static"){
-									// this is a macro | function | structure | namespace declaration
-									// check if the next token is a keyword
-									if (
-										   i == elements.size()-1
-										or elements[i+1].type != ELEMENT_TOKEN
-										or elements[i+1].data.token->type != Lexer::TOKEN_KEYWORD) {
-										// syntax error
-										ParserError error = {elements[i].line, "\"static\" keyword has to be followed by \"macro\", \"function\", \"structure\" or \"namespace\" keyword"};
-										errors.push_back(error);
-										successful = false;
-										break;
-									}
-									else;
-									// split off for each of those
-									if (elements[i+1].value == "macro"){
-										// macro
-										/** structure:
-										 * static macro <type> <name> <body> \n
-										 */
-										int last_good = i+1;
-										bool all_good = true;
-										// check element types
-										if (
-											   elements.size() < i+2
-											or elements[i+2].type != ELEMENT_TOKEN
-											or elements[i+2].data.token->type != Lexer::TOKEN_TYPE
-										){
-											// syntax error
-											ParserError error = {elements[i].line, "Macro declaration must have a type after the \"macro\" keyword"};
-											errors.push_back(error);
-										}
-										else{
-											last_good = i+2;
-										}
-										if (
-											   elements.size() < i+3
-											or elements[i+3].type != ELEMENT_TOKEN
-											or elements[i+3].data.token->type != Lexer::TOKEN_IDENTIFIER
-										){
-											// syntax error
-											ParserError error = {elements[i].line, "Macro declaration must have a name after the type"};
-											errors.push_back(error);
-										}
-										else{
-											last_good = i+3;
-										}
-										if (
-											    elements.size() < i+4
-											or  elements[i+4].type == ELEMENT_TOKEN
-											and elements[i+4].data.token->type == Lexer::TOKEN_NEWLINE
-										){
-											// syntax error
-											ParserError error = {elements[i].line, "Macro declaration must have a body after the name"};
-											errors.push_back(error);
-										}
-
-										if (not all_good){
-											// clean up
-											for (int j = i+1; j <= last_good; j++)
-											{
-												elements.erase(elements.begin()+i);
-											}
-											successful = false;
-											break;
-										}
-										// get the body
-										std::vector<Element> body;
-										do{
-											body.push_back(elements[i+4]);
-											elements.erase(elements.begin()+i+4);
-										}
-										while (
-												elements[i+4].type != ELEMENT_TOKEN
-											and elements[i+4].data.token->type != Lexer::TOKEN_NEWLINE
-											and i+4 < elements.size()
-										);
-										// force the body to be parsed
-										ParseResult res = _parse(body);
-
-										ParserError rootError = {elements[i].line, "In macro declaration:"};
-										for (ParserError error: res.errors){
-											error.previous = &rootError;
-											errors.push_back(error);
-										}
-										if (res.elements.size() != 1){
-											ParserError error = {elements[i].line, "Macro declaration must have a single statement in the body"};
-											errors.push_back(error);
-										}
-										if (not res.successful){
-											successful = false;
-											// clean up
-											for (int j = i+1; j <= last_good; j++)
-											{
-												elements.erase(elements.begin()+i);
-											}
-											break;
-										}
-
-										// compose the macro
-										Element macro = {ELEMENT_MACRO_DEF, elements[i+2].line, elements[i+3].value, ""};
-										macro.data.macro_def.body = &body[0];
-										macro.data.macro_def.name = &elements[i+3].value;
-										macro.data.macro_def.type = get_type(elements[i+2].value);
-
-										// delete the old elements
-										for (int j = i; j <= last_good; j++)
-										{
-											elements.erase(elements.begin()+i-1);
-										}
-									}
-									if (elements[i+1].value == "func"){
-										// function declaration
-										/** structure
-										 * static func <type> <name> (<parameters>)
-										 */
-										int last_good = i+1;
-										bool all_good = true;
-										if (
-											   elements.size() < i+2
-											or elements[i+2].type != ELEMENT_TOKEN
-											or elements[i+2].data.token->type != Lexer::TOKEN_TYPE
-										){
-											// syntax error
-											ParserError error = {elements[i].line, "Function declaration must have a type after the \"static func\" keywords"};
-											errors.push_back(error);
-											all_good = false;
-										}
-										else{
-											last_good = i+2;
-										}
-										if (
-											   elements.size() < i+3
-											or elements[i+3].type != ELEMENT_TOKEN
-											or elements[i+3].data.token->type != Lexer::TOKEN_IDENTIFIER
-										){
-											// syntax error
-											ParserError error = {elements[i].line, "Function declaration must have a name after the type"};
-											errors.push_back(error);
-											all_good = false;
-										}
-										else{
-											last_good = i+3;
-										}
-										if (
-											   elements.size() < i+4
-											or elements[i+4].type != ELEMENT_TOKEN
-											or elements[i+4].data.token->type != Lexer::TOKEN_BRACKET_O
-										){
-											// syntax error
-											ParserError error = {elements[i].line, "Function declaration must have parameters in brackets after the name"};
-											errors.push_back(error);
-											all_good = false;
-										}
-										else{
-											last_good = i+4;
-										}
-										// compose the parameters
-										std::vector<std::string> parameters;
-										std::vector<ValType> parameter_types;
-										std::vector<Element> defaults;
-
-										int j = i+5;
-										while (
-											   elements[j].type != ELEMENT_TOKEN
-											or elements[j].data.token->type != Lexer::TOKEN_BRACKET_C
-										){
-											// check for syntax errors
-											if (
-												   elements.size() < j
-												or elements[j].type != ELEMENT_TOKEN
-												or elements[j].data.token->type != Lexer::TOKEN_TYPE
-											){
-												// syntax error
-												ParserError error = {elements[i].line, "Parameter declaration must start with a type"};
-												errors.push_back(error);
-												all_good = false;
-											}
-											else{
-												last_good = j;
-											}
-											if(
-												   elements.size() < j+1
-												or elements[j+1].type != ELEMENT_TOKEN
-												or elements[j+1].data.token->type != Lexer::TOKEN_IDENTIFIER
-											){
-												// syntax error
-												ParserError error = {elements[i].line, "Parameter declaration must have a name after the type"};
-												errors.push_back(error);
-												all_good = false;
-											}
-											else{
-												last_good = j+1;
-											}
-											if (
-												   elements.size() >= j+2
-												or elements[j+2].type != ELEMENT_TOKEN
-												or (
-													    elements[j+2].data.token->type != Lexer::TOKEN_COMMA
-													and elements[j+2].data.token->type != Lexer::TOKEN_BRACKET_C
-													and elements[j+2].data.token->type != Lexer::TOKEN_NUMBER
-													and elements[j+2].data.token->type != Lexer::TOKEN_QUOTE
-													and elements[j+2].data.token->type != Lexer::TOKEN_NULL
-												)
-											){
-												// syntax error
-												ParserError error = {elements[i].line, "Syntax error:\"" + elements[j+2].data.token->value + "\" is unexpected here"};
-												errors.push_back(error);
-												all_good = false;
-											}
-											else{
-												last_good = j+2;
-											}
-											// if not all_good, don't bother with creating the parameters
-											if (all_good){
-												if
-												parameter_types.push_back(get_type(elements[j].value));
-												parameters.push_back(elements[j+1].data.token->value);
-
-												// check if there is a default value
-												if (
-													    elements[j+2].data.token->type != Lexer::TOKEN_QUOTE
-													and elements[j+2].data.token->type != Lexer::TOKEN_BRACKET_C
-												){
-
-												}
-											}
-										}
-									}
-								}
-							}
-							break;
-						// error
-						// default:
-						// 	{
-						// 		PaserError error = {elements[i].line, "Unexpected token"};
-						// 		errors.push_back(error);
-						// 		successfull = false;
-						// 		// remove the token
-						// 	}
-						// 	break;
+		/**
+		 * how tightly a binary operator holds on to its operands, 0 for the ones which are not binary
+		 *
+		 * all binary operators share one level, so chains are evaluated left to right
+		 */
+		constexpr int binding(char op){
+			return op == PREFIX or op == POSTFIX ? 0 : 1;
+		}
+	}
+
+	/**
+	 * single pass parser, recursive descent for statements and declarations,
+	 * precedence climbing for expressions
+	 *
+	 * every token is looked at a bounded number of times, so parsing is linear in the size of the input,
+	 * nodes are appended to the tree once all of their children are
+	 *
+	 * after an error the rest of the statement is skipped, up to the next newline, or the "]" closing the body it is in,
+	 * brackets and strings on the way are jumped over as a whole, so broken input costs no more than the correct kind
+	 *
+	 * chains of operators and runs of prefix operators are read in loops, only brackets, calls and bodies recurse,
+	 * and they are an error past MAX_NESTING levels instead of running out of stack
+	 */
+	template<bool Trace>
+	class Reader{
+		public:
+			// parses the tokens in [begin, end), which have to be whole top level statements
+			Reader(const Lexer::TokenBuffer& tokens, uint32_t max_errors, uint32_t begin, uint32_t end)
+				: Reader(tokens, Diagnostics(max_errors), begin, end){}
+
+			// goes on from the errors of the statements before begin, like a parse of all of them would
+			Reader(const Lexer::TokenBuffer& tokens, Diagnostics&& errors, uint32_t begin, uint32_t end)
+				: tokens(tokens), end(end), pos(begin), errors(std::move(errors)){
+				tree.code = tokens.code;
+				if (begin < end)
+					line = tokens.line(begin);
+				// about a third of the tokens become nodes, enough to not have to grow most of the time
+				tree.nodes.reserve((end - begin) / 3 + 16);
+				tree.extra.reserve((end - begin) / 4 + 16);
+				tree.nodes.push_back({ELEMENT_VOID});
+				// extra starts with an empty list, for functions without a body
+				tree.extra.push_back(0);
+			}
+
+			ParseResult parse(){
+				Frame top(scratch);
+				while (not done()){
+					if (is(Lexer::TOKEN_NEWLINE)){
+						advance();
+						continue;
 					}
+					NodeId statement = this->statement();
+					if (statement != FAILED)
+						scratch.push_back(statement);
+					end_statement(statement, false);
 				}
+				tree.top = collect(top);
+				bool successful = errors.empty();
+				return {std::move(tree), std::move(errors), successful};
 			}
 
+		private:
+			// returned instead of a node when parsing it failed
+			static const NodeId FAILED = UINT32_MAX;
 
-		}
-		while(did_something);
+			const Lexer::TokenBuffer& tokens;
+			Tree tree;
+			uint32_t end;
+			uint32_t pos;
+			// line of the token at pos
+			int line = 1;
+			Diagnostics errors;
+			// set once there are too many errors, from then on the input looks like it ended
+			bool stopped = false;
 
-		return {elements, errors, successful};
-	}
+			// items of the lists being built, the innermost list is on top
+			std::vector<uint32_t> scratch;
+			// contents of the string being put together
+			std::string text;
 
-	ParseResult _parse(std::vector<Lexer::Token> tokens){
-		std::vector<Element> elements;
+			// brackets, calls and bodies the parser is inside of, each of them is a few calls deeper on the stack
+			uint32_t nesting = 0;
+			// well within a megabyte of stack, the parallel parts run on threads with the default size of it
+			static const uint32_t MAX_NESTING = 1000;
 
-		for (int i = 0; i < tokens.size(); i++){
-			Element element = {ELEMENT_TOKEN, tokens[i].line, tokens[i].value, tokens[i].debug};
-			element.data.token = &tokens[i];
-			elements.push_back(element);
-		}
+			struct Nested{
+				uint32_t& nesting;
 
-		return _parse(elements);
-	}
+				Nested(uint32_t& nesting) : nesting(nesting){
+					nesting++;
+				}
 
-}
+				~Nested(){
+					nesting--;
+				}
+			};
 
-int main(int argc, char *argv[]){
-	argparse::ArgumentParser program("CFuSS");
+			// a list on the scratch stack, whatever it left there is dropped once it is done, also when it bails out early
+			struct Frame{
+				std::vector<uint32_t>& stack;
+				size_t start;
 
-	program.add_argument("input")
-		.required()
-		.help("input file");
+				Frame(std::vector<uint32_t>& stack) : stack(stack), start(stack.size()){}
 
-	program.add_argument("--output", "-o")
-		.default_value("output")
-		.help("output file");
+				~Frame(){
+					stack.resize(start);
+				}
+			};
 
-	program.add_argument("--c-compiler", "-c")
-		.default_value("gcc")
-		.help("c compiler to use");
+			// appends the list to extra, returns where it is
+			uint32_t collect(const Frame& frame){
+				uint32_t at = tree.extra.size();
+				tree.extra.push_back(scratch.size() - frame.start);
+				tree.extra.insert(tree.extra.end(), scratch.begin() + frame.start, scratch.end());
+				return at;
+			}
 
-	program.add_argument("--stop-at-c", "-s")
-		.default_value(false)
-		.implicit_value(true)
-		.help("Don't compile the C code, and output it.");
+			bool done(uint32_t ahead = 0) const{
+				return stopped or pos + ahead >= end;
+			}
 
-	program.add_argument("--tokens")
-		.default_value(false)
-		.implicit_value(true)
-		.help("Print the tokens.");
+			bool is(Lexer::TokenType type, uint32_t ahead = 0) const{
+				return not done(ahead) and tokens.type(pos + ahead) == type;
+			}
 
-	program.add_argument("--ast")
-		.default_value(false)
-		.implicit_value(true)
-		.help("Print the AST.");
+			// a newline, the end of the input or the end of a body
+			bool ends_statement() const{
+				return done() or is(Lexer::TOKEN_NEWLINE) or is(Lexer::TOKEN_SQ_BRACKET_C);
+			}
 
-	try{
-		program.parse_args(argc, argv);
-	}
-	catch(const std::runtime_error& e){
-		std::cerr << e.what() << std::endl;
-		std::cerr << program;
-		return 1;
-	}
+			void advance(){
+				jump(pos + 1);
+			}
 
-	// try to open the input file
-	std::ifstream input(program.get<std::string>("input"));
-	if(!input.is_open()){
-		std::cerr << "Could not open input file. Terminating." << std::endl;
-		return 1;
-	}
-	// tokenize the input file
-	std::string code;
-	std::getline(input, code, '\0');
-	input.close();
-	std::vector<Lexer::Token> tokens = Lexer::tokenize(code);
+			void jump(uint32_t to){
+				pos = to;
+				// the tokens are in order, so the line only ever moves forward
+				while (not done() and line < tokens.lines.count() and tokens.lines.starts[line] <= tokens.offsets[pos])
+					line++;
+			}
+
+			// the token closing the bracket or string opened at pos, or NO_PARTNER
+			uint32_t partner() const{
+				return tokens.partners[pos];
+			}
 
-	printf("tokenized successfully\n");
+			// if the partner of pos points back at it
+			bool closed() const{
+				uint32_t other = partner();
+				return other < tokens.size() and tokens.partners[other] == pos;
+			}
 
-	if (program.get<bool>("--tokens")){
-		// print the tokens
-		printf("\n");
+			// a node for the token at pos
+			Node make(ElementType type) const{
+				return {(uint8_t) type, 0, 0, line, tokens.offsets[pos], tokens.lengths[pos], NO_NODE, NO_NODE};
+			}
 
-		int max_value_length = 0;
-		for (Lexer::Token token : tokens){
-			if (escape(token.value).length() > max_value_length)
-				max_value_length = escape(token.value).length();
-		}
+			NodeId add(const Node& node){
+				tree.nodes.push_back(node);
+				return tree.nodes.size() - 1;
+			}
 
-		for (int i = 0; i < tokens.size(); i++){
-			Lexer::Token token = tokens[i];
-			printf(
-				"[%2d] %2d: \"%s\"%*s%d %-4s\n",
-				i,
-				token.type, escape(token.value).c_str(),
-				max_value_length - escape(token.value).length() + 6,
-				" line ", token.line, token.debug.c_str()
-			);
-		}
-	}
+			// widens the text of the node up to the end of the given one
+			void extend(Node& node, uint32_t offset, uint32_t length) const{
+				node.length = offset + length - node.offset;
+			}
 
-	// parse the tokens
-	Parser::ParseResult res = Parser::_parse(tokens);
-	std::vector<Parser::Element> elements = res.elements;
+			void extend(Node& node, NodeId id) const{
+				extend(node, tree.nodes[id].offset, tree.nodes[id].length);
+			}
 
-	if (!res.successful){
-		std::vector<std::string> lines = split_string(code, "\n");
-		// show the errors
-		for (Parser::ParserError error : res.errors){
-			printf("%s:\n", error.message.c_str());
-			// print the line
-			printf("%d | %s\n", error.line, lines[error.line-1].c_str());
+			NodeId error(uint32_t at, std::string_view message){
+				// errors at the end of the input are about the last token
+				if (at >= tokens.size())
+					at = tokens.size() - 1;
+				errors.add(tokens.line(at), message, tokens.value(at));
+				stopped = errors.full();
+				return FAILED;
+			}
 
-		}
+			void trace(int line, std::string message){
+				trace_log.push_back({line, std::move(message)});
+			}
 
-		std::cerr << "Parsing failed. Terminating." << std::endl;
-		return 1;
-	}
+			NodeId statement(){
+				if (is(Lexer::TOKEN_KEYWORD)){
+					if (tokens.value(pos) == "static")
+						return declaration();
+					if (tokens.value(pos) == "serve")
+						return serve();
+				}
+				return expression();
+			}
 
-	else{
-		printf("parsed successfully\n");
-	}
-	printf("got %d elements\n", elements.size());
+			void end_statement(NodeId statement, bool in_body){
+				if (done() or is(Lexer::TOKEN_NEWLINE) or (in_body and is(Lexer::TOKEN_SQ_BRACKET_C)))
+					return;
+				// errors were already reported where they happened
+				if (statement != FAILED)
+					error(pos, "Unexpected token");
+				// skip the rest of the statement, brackets and strings as a whole, so a body does not end up parsed as statements of its own
+				while (not done() and not is(Lexer::TOKEN_NEWLINE) and not (in_body and is(Lexer::TOKEN_SQ_BRACKET_C))){
+					// closing tokens point back at what they close
+					if (partner() == Lexer::NO_PARTNER or partner() < pos)
+						advance();
+					else
+						// up to where a string which is not closed breaks off
+						jump(closed() ? partner() + 1 : partner());
+				}
+			}
 
-	// print the elements
-	printf("\n");
+			// serve [<expression>]
+			NodeId serve(){
+				Node node = make(ELEMENT_SERVE);
+				advance();
+				if (not ends_statement()){
+					node.a = expression();
+					if (node.a == FAILED)
+						return FAILED;
+					extend(node, node.a);
+				}
+				if constexpr (Trace)
+					trace(node.line, "serve");
+				return add(node);
+			}
 
-	int max_value_length = 0;
-	for (Parser::Element element : elements){
-		if (escape(element.value).length() > max_value_length)
-			max_value_length = escape(element.value).length();
-	}
+			NodeId declaration(){
+				uint32_t start = pos;
+				advance();
+				if (is(Lexer::TOKEN_KEYWORD)){
+					std::string_view kind = tokens.value(pos);
+					if (kind == "macro")
+						return macro(start);
+					if (kind == "func")
+						return function(start);
+					if (kind == "structure" or kind == "namespace")
+						return error(pos, "\"static " + std::string(kind) + "\" declarations are not supported yet");
+				}
+				return error(start, "\"static\" keyword has to be followed by \"macro\", \"function\", \"structure\" or \"namespace\" keyword");
+			}
 
-	for (Parser::Element element : elements){
-		printf(
-			"%2d: \"%s\"%*s%d %-4s\n",
-			element.type, escape(element.value).c_str(),
-			max_value_length - escape(element.value).length() + 6,
-			" line ", element.line, element.debug.c_str()
-		);
+			// static macro <type> <name> <body>
+			NodeId macro(uint32_t start){
+				advance();
+				if (not is(Lexer::TOKEN_TYPE))
+					return error(start, "Macro declaration must have a type after the \"macro\" keyword");
+				ValType type = get_type(tokens.value(pos));
+				advance();
+				if (not is(Lexer::TOKEN_IDENTIFIER))
+					return error(start, "Macro declaration must have a name after the type");
+				Node node = make(ELEMENT_MACRO_DEF);
+				node.a = tokens.symbols[pos];
+				advance();
+				if (ends_statement())
+					return error(start, "Macro declaration must have a body after the name");
+
+				NodeId body = expression();
+				if (body == FAILED)
+					return FAILED;
+				if (not ends_statement())
+					return error(start, "Macro declaration must have a single statement in the body");
+
+				node.b = tree.extra.size();
+				tree.extra.push_back(type.packed());
+				tree.extra.push_back(body);
+				if constexpr (Trace)
+					trace(node.line, "macro");
+				return add(node);
+			}
+
+			// static func <type> <name> (<type> <name> [<default>], ...) [[<body>]]
+			NodeId function(uint32_t start){
+				advance();
+				if (not is(Lexer::TOKEN_TYPE))
+					return error(start, "Function declaration must have a type after the \"static func\" keywords");
+				ValType ret_type = get_type(tokens.value(pos));
+				advance();
+				if (not is(Lexer::TOKEN_IDENTIFIER))
+					return error(start, "Function declaration must have a name after the type");
+				Node node = make(ELEMENT_FUNCTION_DEF);
+				node.a = tokens.symbols[pos];
+				advance();
+				if (not is(Lexer::TOKEN_BRACKET_O))
+					return error(start, "Function declaration must have parameters in brackets after the name");
+				advance();
+
+				// parameters, three items each
+				Frame parameters(scratch);
+				while (not is(Lexer::TOKEN_BRACKET_C)){
+					if (not is(Lexer::TOKEN_TYPE))
+						return error(start, "Parameter declaration must start with a type");
+					ValType type = get_type(tokens.value(pos));
+					advance();
+					if (not is(Lexer::TOKEN_IDENTIFIER))
+						return error(start, "Parameter declaration must have a name after the type");
+					Symbols::Symbol name = tokens.symbols[pos];
+					advance();
+
+					NodeId fallback = NO_NODE;
+					if (is(Lexer::TOKEN_NUMBER) or is(Lexer::TOKEN_QUOTE) or is(Lexer::TOKEN_NULL)){
+						fallback = literal();
+						if (fallback == FAILED)
+							return FAILED;
+					}
+					if (not is(Lexer::TOKEN_COMMA) and not is(Lexer::TOKEN_BRACKET_C))
+						return error(start, "Syntax error:\"" + (done() ? "EOF" : escape(tokens.value(pos))) + "\" is unexpected here");
+
+					scratch.push_back(name);
+					scratch.push_back(type.packed());
+					scratch.push_back(fallback);
+					if (is(Lexer::TOKEN_COMMA))
+						advance();
+				}
+				advance();
+
+				// the body goes into extra before the parameters are, its slot is filled in after
+				node.b = tree.extra.size();
+				tree.extra.push_back(ret_type.packed());
+				tree.extra.push_back(0);
+				tree.extra.push_back((scratch.size() - parameters.start) / 3);
+				tree.extra.insert(tree.extra.end(), scratch.begin() + parameters.start, scratch.end());
+
+				// the body is optional, without one this only declares the function
+				if (is(Lexer::TOKEN_SQ_BRACKET_O)){
+					uint32_t open = pos;
+					Frame body(scratch);
+					Nested nested(nesting);
+					if (nesting > MAX_NESTING)
+						return error(open, "Function is nested too deeply");
+					advance();
+					while (not is(Lexer::TOKEN_SQ_BRACKET_C)){
+						if (done())
+							return error(open, "Missing closing square bracket");
+						if (is(Lexer::TOKEN_NEWLINE)){
+							advance();
+							continue;
+						}
+						NodeId statement = this->statement();
+						if (statement != FAILED)
+							scratch.push_back(statement);
+						end_statement(statement, true);
+					}
+					tree.extra[node.b + 1] = collect(body);
+					advance();
+				}
+				if constexpr (Trace)
+					trace(node.line, "function");
+				return add(node);
+			}
+
+			NodeId expression(int min_binding = 1){
+				NodeId left = operand();
+				while (left != FAILED and is(Lexer::TOKEN_OPERATOR)){
+					char op = tokens.value(pos)[0];
+					int binding = Operators::binding(op);
+					if (binding == 0 or binding < min_binding)
+						break;
+					Node node = make(ELEMENT_OPERATION);
+					node.aux = op;
+					advance();
+					// operators on the same level group to the left
+					NodeId right = expression(binding + 1);
+					if (right == FAILED)
+						return FAILED;
+					node.a = left;
+					node.b = right;
+					node.offset = tree.nodes[left].offset;
+					extend(node, right);
+					if constexpr (Trace)
+						trace(node.line, std::string("op ") + op);
+					left = add(node);
+				}
+				return left;
+			}
+
+			// a single operand, with its prefix and postfix operators
+			NodeId operand(){
+				// prefix operators hold on to the whole rest of the operand, a run of them is wrapped around it once that is parsed
+				uint32_t prefixes = pos;
+				int prefix_line = line;
+				while (is(Lexer::TOKEN_OPERATOR) and tokens.value(pos)[0] == Operators::PREFIX)
+					advance();
+				uint32_t base = pos;
+
+				if (pos > 0 and tokens.type(pos-1) == Lexer::TOKEN_OPERATOR and (
+					   ends_statement()
+					or is(Lexer::TOKEN_BRACKET_C)
+					or is(Lexer::TOKEN_COMMA)
+				)){
+					if (done())
+						return error(pos-1, "EOF while looking for operands");
+					return error(pos-1, "Unexpected operator (expected operand after operator)");
+				}
+				if (done())
+					return error(pos, "Unexpected token");
+
+				NodeId id;
+				switch (tokens.type(pos)){
+					case Lexer::TOKEN_OPERATOR:
+						{
+							std::string_view op = tokens.value(pos);
+							std::string message = "Unexpected operator";
+							if (pos > 0 and tokens.type(pos-1) == Lexer::TOKEN_OPERATOR)
+								message += " (" + std::string(tokens.value(pos-1)) + ")";
+							else if (pos > 0)
+								message += " (expected operand before operator)";
+							if (pos > 0 and op == "-")
+								message += " (did you mean to use `~`?)";
+							return error(pos, message);
+						}
+					case Lexer::TOKEN_NUMBER:
+					case Lexer::TOKEN_NULL:
+					case Lexer::TOKEN_QUOTE:
+					case Lexer::TOKEN_MULTILINE_STRING_START:
+						id = literal();
+						break;
+					case Lexer::TOKEN_MULTILINE_STRING_END:
+						return error(pos, "Unexpected closing multiline string");
+					case Lexer::TOKEN_IDENTIFIER:
+						if (is(Lexer::TOKEN_BRACKET_O, 1)){
+							id = call();
+							break;
+						}
+						// it is a reference
+						{
+							Node node = make(ELEMENT_REF);
+							node.a = tokens.symbols[pos];
+							advance();
+							id = add(node);
+						}
+						break;
+					case Lexer::TOKEN_BRACKET_O:
+						{
+							uint32_t open = pos;
+							if (partner() == Lexer::NO_PARTNER)
+								return error(open, "Missing closing bracket");
+							Nested nested(nesting);
+							if (nesting > MAX_NESTING)
+								return error(open, "Expression is nested too deeply");
+							advance();
+							id = expression();
+							if (id == FAILED)
+								return FAILED;
+							if (not is(Lexer::TOKEN_BRACKET_C))
+								return error(pos, "Expected \")\" after the expression");
+							Node& node = tree.nodes[id];
+							node.offset = tokens.offsets[open];
+							extend(node, tokens.offsets[pos], tokens.lengths[pos]);
+							advance();
+						}
+						break;
+					default:
+						return error(pos, "Unexpected token");
+				}
+
+				while (id != FAILED and is(Lexer::TOKEN_OPERATOR) and tokens.value(pos)[0] == Operators::POSTFIX){
+					Node node = make(ELEMENT_OPERATION);
+					node.aux = Operators::POSTFIX;
+					node.a = id;
+					node.offset = tree.nodes[id].offset;
+					extend(node, tokens.offsets[pos], tokens.lengths[pos]);
+					advance();
+					id = add(node);
+				}
+
+				// the prefix closest to the operand is the innermost
+				for (uint32_t i = base; id != FAILED and i-- > prefixes;){
+					Node node = {ELEMENT_OPERATION, Operators::PREFIX, 0, prefix_line, tokens.offsets[i], tokens.lengths[i], NO_NODE, id};
+					extend(node, id);
+					if constexpr (Trace)
+						trace(node.line, std::string("op ") + Operators::PREFIX);
+					id = add(node);
+				}
+				return id;
+			}
+
+			// <name>(<expression>, ...)
+			NodeId call(){
+				uint32_t name = pos;
+				Node node = make(ELEMENT_FUNCTION_CALL);
+				node.a = tokens.symbols[pos];
+				Frame args(scratch);
+				advance();
+				if (partner() == Lexer::NO_PARTNER)
+					return error(name, "Missing closing bracket");
+				Nested nested(nesting);
+				if (nesting > MAX_NESTING)
+					return error(name, "Expression is nested too deeply");
+				advance();
+				while (not is(Lexer::TOKEN_BRACKET_C)){
+					if (is(Lexer::TOKEN_COMMA))
+						return error(name, "Unexpected comma, expected expression");
+					NodeId argument = expression();
+					if (argument == FAILED)
+						return FAILED;
+					scratch.push_back(argument);
+					if (is(Lexer::TOKEN_COMMA))
+						advance();
+					else if (not is(Lexer::TOKEN_BRACKET_C))
+						return error(pos, "Expected \",\" or \")\" after an argument");
+				}
+				node.b = collect(args);
+				extend(node, tokens.offsets[pos], tokens.lengths[pos]);
+				advance();
+				if constexpr (Trace)
+					trace(node.line, "call " + std::string(tokens.value(name)));
+				return add(node);
+			}
+
+			NodeId literal(){
+				Node node = make(ELEMENT_LITERAL);
+				switch (tokens.type(pos)){
+					case Lexer::TOKEN_NUMBER:
+						{
+							node.aux = _ValType::TYPE_NUM;
+							std::string_view value = tokens.value(pos);
+							double num;
+							if (value == "true" or value == "false")
+								num = value == "true";
+							else{
+								std::from_chars_result res = std::from_chars(value.data(), value.data() + value.size(), num, std::chars_format::fixed);
+								if (res.ec != std::errc())
+									return error(pos, "Number is too large");
+							}
+							uint64_t bits;
+							std::memcpy(&bits, &num, sizeof(bits));
+							node.a = (uint32_t) bits;
+							node.b = (uint32_t) (bits >> 32);
+							advance();
+							return add(node);
+						}
+					case Lexer::TOKEN_NULL:
+						node.aux = _ValType::TYPE_VOID;
+						advance();
+						return add(node);
+					case Lexer::TOKEN_QUOTE:
+						return string();
+					default:
+						return multiline_string();
+				}
+			}
+
+			// stores the text put together in text as the contents of a string literal
+			void store_text(Node& node){
+				node.a = tree.strings.size();
+				node.b = text.size();
+				tree.strings += text;
+			}
+
+			/**
+			 * single line strings have:
+			 *
+			 *     TOKEN_QUOTE <random token(s)> TOKEN_QUOTE
+			 */
+			NodeId string(){
+				uint32_t open = pos;
+				uint32_t close = partner();
+				if (close == Lexer::NO_PARTNER)
+					return error(open, "Expected closing quote");
+				Node node = make(ELEMENT_LITERAL);
+				node.aux = _ValType::TYPE_STR;
+				uint32_t length = 0;
+				for (uint32_t i = open + 1; i < close; i++)
+					length += tokens.lengths[i];
+				jump(close);
+				uint32_t first = tokens.offsets[open] + tokens.lengths[open];
+				if (tokens.offsets[pos] - first == length){
+					// the tokens cover everything between the quotes, so the source is the string
+					node.flags |= FLAG_IN_SOURCE;
+					node.a = first;
+					node.b = length;
+				}
+				else{
+					text.clear();
+					for (uint32_t i = open + 1; i < pos; i++)
+						text += tokens.value(i);
+					store_text(node);
+				}
+				extend(node, tokens.offsets[pos], tokens.lengths[pos]);
+				advance();
+				return add(node);
+			}
+
+			/**
+			 * multi line strings have:
+			 *
+			 *     TOKEN_MULTILINE_STRING_START <random token(s) (optional)> TOKEN_NEWLINE
+			 *     TOKEN_QUOTE <random token(s)> TOKEN_NEWLINE
+			 *     TOKEN_MULTILINE_STRING_END
+			 */
+			NodeId multiline_string(){
+				uint32_t close = partner();
+				bool is_closed = closed();
+				Node node = make(ELEMENT_LITERAL);
+				node.aux = _ValType::TYPE_STR;
+				text.clear();
+				advance();
+				if (is(Lexer::TOKEN_NEWLINE))
+					advance();
+
+				bool in_string = true;
+				while (not done() and not is(Lexer::TOKEN_MULTILINE_STRING_END)){
+					if (in_string){
+						if (is(Lexer::TOKEN_NEWLINE)){
+							text += "\n";
+							in_string = false;
+						}
+						else
+							text += tokens.value(pos);
+					}
+					else if (not is(Lexer::TOKEN_QUOTE))
+						break;
+					else
+						in_string = true;
+					advance();
+				}
+
+				if (not is(Lexer::TOKEN_MULTILINE_STRING_END)){
+					// the string can still be closed later on, before the next one starts
+					if (not is_closed)
+						return error(pos, "Expected closing multiline string");
+					error(pos, "Multiline string continuation missing");
+					// skip the rest of the string
+					jump(close + 1);
+					return FAILED;
+				}
+				store_text(node);
+				extend(node, tokens.offsets[pos], tokens.lengths[pos]);
+				advance();
+				return add(node);
+			}
+	};
+
+	/**
+	 * the end of the top level statement starting at the token i, past its newline
+	 *
+	 * bodies and strings are jumped over with the partner table like the parser skips them,
+	 * a body which is never closed takes the rest of the input, the parser reads up to the end looking for its bracket
+	 */
+	uint32_t statement_end(const Lexer::TokenBuffer& tokens, uint32_t i){
+		uint32_t size = tokens.size();
+		while (i < size){
+			uint32_t other = tokens.partners[i];
+			if (tokens.type(i) == Lexer::TOKEN_NEWLINE)
+				return i + 1;
+			if (other != Lexer::NO_PARTNER and other > i)
+				// up to where a string which is not closed breaks off
+				i = other < size and tokens.partners[other] == i ? other + 1 : other;
+			else if (tokens.type(i) == Lexer::TOKEN_SQ_BRACKET_O)
+				return size;
+			else
+				i++;
+		}
+		return size;
+	}
+
+	// where the nodes, extra and strings of a part, the tree of some statements parsed on their own, end up in the whole tree
+	struct Shift{
+		uint32_t nodes;
+		uint32_t extra;
+		uint32_t strings;
+
+		// the void node of the part becomes the one of the whole tree
+		NodeId node(NodeId id) const{
+			return id == NO_NODE ? NO_NODE : id + nodes;
+		}
+
+		// and so does the empty list
+		uint32_t list(uint32_t at) const{
+			return at == 0 ? 0 : at + extra;
+		}
+	};
+
+	// fixes up a node of a part, and what it has in extra, after they were copied into the whole tree
+	void rebase(Node& node, std::vector<uint32_t>& extra, const Shift& shift){
+		switch (node.type){
+			case ELEMENT_OPERATION:
+				node.a = shift.node(node.a);
+				node.b = shift.node(node.b);
+				break;
+			case ELEMENT_LITERAL:
+				if (node.aux == _ValType::TYPE_STR and not (node.flags & FLAG_IN_SOURCE))
+					node.a += shift.strings;
+				break;
+			case ELEMENT_SERVE:
+				node.a = shift.node(node.a);
+				break;
+			case ELEMENT_FUNCTION_CALL:
+				node.b = shift.list(node.b);
+				for (uint32_t i = 1; i <= extra[node.b]; i++)
+					extra[node.b + i] = shift.node(extra[node.b + i]);
+				break;
+			case ELEMENT_MACRO_DEF:
+				node.b = shift.list(node.b);
+				extra[node.b + 1] = shift.node(extra[node.b + 1]);
+				break;
+			case ELEMENT_FUNCTION_DEF:
+				{
+					node.b = shift.list(node.b);
+					uint32_t body = extra[node.b + 1] = shift.list(extra[node.b + 1]);
+					// the empty list is shared, and was never shifted
+					if (body != 0)
+						for (uint32_t i = 1; i <= extra[body]; i++)
+							extra[body + i] = shift.node(extra[body + i]);
+					uint32_t* parameters = extra.data() + node.b + 3;
+					for (uint32_t i = 0; i < extra[node.b + 2]; i++)
+						parameters[i*3 + 2] = shift.node(parameters[i*3 + 2]);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	namespace Parallel{
+		// below this many tokens the threads cost more than they save
+		const uint32_t MIN_TOKENS = 1 << 16;
+		// ranges per thread, so a long function does not hold up everyone else
+		const int RANGES_PER_THREAD = 4;
+
+		// splits the tokens into about count ranges of whole top level statements
+		std::vector<uint32_t> split(const Lexer::TokenBuffer& tokens, int count){
+			std::vector<uint32_t> bounds{0};
+			uint32_t size = tokens.size();
+			uint32_t next = size / count;
+			for (uint32_t i = statement_end(tokens, 0); i < size; i = statement_end(tokens, i)){
+				if (i >= next){
+					bounds.push_back(i);
+					next = i + size / count;
+				}
+			}
+			bounds.push_back(size);
+			return bounds;
+		}
+
+		/**
+		 * parses ranges of top level statements on the thread pool, each into a tree of its own,
+		 * and merges them into one in source order, as if it was parsed in one go
+		 */
+		ParseResult parse(const Lexer::TokenBuffer& tokens, uint32_t max_errors, Threads::Pool& pool){
+			std::vector<uint32_t> bounds = split(tokens, pool.size() * RANGES_PER_THREAD);
+			int count = bounds.size() - 1;
+			std::vector<ParseResult> parts(count);
+			std::unique_ptr<bool[]> parsed(new bool[count]());
+			// the first part which reached the limit on its own, the ones after it are most likely past where the parse stops
+			std::atomic<int> first_full{count};
+			pool.run(count, [&](int k){
+				if (k > first_full.load(std::memory_order_relaxed))
+					return;
+				parts[k] = Reader<false>(tokens, max_errors, bounds[k], bounds[k+1]).parse();
+				parsed[k] = true;
+				if (parts[k].errors.full())
+					for (int seen = first_full.load(); k < seen and not first_full.compare_exchange_weak(seen, k);)
+						;
+			});
+
+			/**
+			 * the errors go through the limit and the rule of one per line again, in order, so they come out like in one go,
+			 * the part where they reach the limit is parsed again, going on from the errors before it, so it stops where
+			 * a parse in one go does, and the parts after it are dropped
+			 */
+			Diagnostics errors(max_errors);
+			for (int k = 0; k < count; k++){
+				if (not parsed[k])
+					parts[k] = Reader<false>(tokens, max_errors, bounds[k], bounds[k+1]).parse();
+				for (const ParserError& error : parts[k].errors.list())
+					errors.add(error.line, error.message, error.at);
+				if (not errors.full())
+					continue;
+				Diagnostics before(max_errors);
+				for (int j = 0; j < k; j++)
+					for (const ParserError& error : parts[j].errors.list())
+						before.add(error.line, error.message, error.at);
+				parts[k] = Reader<false>(tokens, std::move(before), bounds[k], bounds[k+1]).parse();
+				errors = std::move(parts[k].errors);
+				count = k + 1;
+			}
+			parts.resize(count);
+
+			// every part starts with the void node and the empty list, and its list of statements is the last thing in its extra,
+			// those are left out, the whole tree has its own
+			std::vector<Shift> shifts(count);
+			std::vector<uint32_t> tops(count);
+			uint32_t nodes = 1;
+			uint32_t extra = 1;
+			uint32_t strings = 0;
+			uint32_t top = 0;
+			for (int k = 0; k < count; k++){
+				const Tree& part = parts[k].tree;
+				shifts[k] = {nodes - 1, extra - 1, strings};
+				tops[k] = top;
+				nodes += part.nodes.size() - 1;
+				extra += part.top - 1;
+				strings += part.strings.size();
+				top += part.statements().size();
+			}
+
+			Tree tree;
+			tree.code = tokens.code;
+			tree.nodes.resize(nodes);
+			tree.nodes[0] = {ELEMENT_VOID};
+			tree.extra.resize(extra + 1 + top);
+			tree.extra[0] = 0;
+			tree.top = extra;
+			tree.extra[extra] = top;
+			tree.strings.resize(strings);
+			pool.run(count, [&](int k){
+				Tree& part = parts[k].tree;
+				const Shift& shift = shifts[k];
+				std::copy(part.nodes.begin() + 1, part.nodes.end(), tree.nodes.begin() + shift.nodes + 1);
+				std::copy(part.extra.begin() + 1, part.extra.begin() + part.top, tree.extra.begin() + shift.extra + 1);
+				std::copy(part.strings.begin(), part.strings.end(), tree.strings.begin() + shift.strings);
+				for (uint32_t i = shift.nodes + 1; i < shift.nodes + part.nodes.size(); i++)
+					rebase(tree.nodes[i], tree.extra, shift);
+				uint32_t* statements = tree.extra.data() + tree.top + 1 + tops[k];
+				for (NodeId id : part.statements())
+					*statements++ = shift.node(id);
+				part = Tree();
+			});
+
+			bool successful = errors.empty();
+			return {std::move(tree), std::move(errors), successful};
+		}
+	}
+
+	// the tree keeps pointing into the source buffer of the tokens
+	template<bool Trace>
+	ParseResult _parse(const Lexer::TokenBuffer& tokens, uint32_t max_errors){
+		// the trace log is shared between the threads, so tracing parses in one go
+		if (not Trace and tokens.size() >= Parallel::MIN_TOKENS and Threads::cores() > 1)
+			return Parallel::parse(tokens, max_errors, Threads::pool());
+		return Reader<Trace>(tokens, max_errors, 0, tokens.size()).parse();
+	}
+
+	// with trace, the parser records what it did in trace_log, it stops after max_errors errors, 0 for no limit
+	ParseResult _parse(const Lexer::TokenBuffer& tokens, bool trace = false, uint32_t max_errors = 0){
+		if (trace)
+			return _parse<true>(tokens, max_errors);
+		return _parse<false>(tokens, max_errors);
+	}
+
+	/**
+	 * the children of a node, in source order
+	 *
+	 * a list of them in Tree::extra, or a and b of the node, for operators and serve, then an operand a prefix or postfix operator
+	 * does not have is NO_NODE, the children of a function are the statements of its body, the defaults of its parameters are literals,
+	 * see Function
+	 */
+	struct Children{
+		static const uint32_t IN_NODE = UINT32_MAX;
+
+		// where the list starts in extra, or IN_NODE
+		uint32_t list;
+		uint32_t count;
+
+		NodeId get(const Tree& tree, NodeId id, uint32_t i) const{
+			if (list != IN_NODE)
+				return tree.extra[list + i];
+			return i == 0 ? tree[id].a : tree[id].b;
+		}
+
+		static Children of(const Tree& tree, NodeId id){
+			const Node& node = tree[id];
+			switch (node.type){
+				case ELEMENT_OPERATION:
+					return {IN_NODE, 2};
+				case ELEMENT_SERVE:
+					return {IN_NODE, 1};
+				case ELEMENT_FUNCTION_CALL:
+					return {node.b + 1, tree.extra[node.b]};
+				case ELEMENT_MACRO_DEF:
+					return {node.b + 1, 1};
+				case ELEMENT_FUNCTION_DEF:
+					{
+						uint32_t body = tree.extra[node.b + 1];
+						return {body + 1, tree.extra[body]};
+					}
+				default:
+					return {IN_NODE, 0};
+			}
+		}
+	};
+
+	// does nothing on every step of a walk, visitors derive from it and hide the steps they need
+	struct Visitor{
+		// before the children of the node, false leaves them out
+		bool enter(NodeId id, uint32_t depth){
+			return true;
+		}
+
+		// between two children, before the one at index i
+		void between(NodeId id, uint32_t i, uint32_t depth){}
+
+		// after the children, only for the nodes which were entered
+		void leave(NodeId id, uint32_t depth){}
+	};
+
+	/**
+	 * walks subtrees depth first, keeping the path to the current node on a stack of its own instead of the call stack
+	 *
+	 * chains of operators are as deep as they are long, a million operands is a million levels,
+	 * so nothing which goes over a whole tree may recurse, this takes constant time per node at any depth
+	 *
+	 * the stack is kept between walks, a visitor cannot start a walk of its own with the same walker
+	 */
+	class Walker{
+		public:
+			Walker(const Tree& tree) : tree(tree){}
+
+			template<typename V>
+			void walk(NodeId root, V& visitor){
+				if (root == NO_NODE or not visitor.enter(root, 0))
+					return;
+				push(root, visitor, 0);
+				while (not stack.empty()){
+					Step& step = stack.back();
+					uint32_t depth = stack.size() - 1;
+					NodeId next = NO_NODE;
+					while (next == NO_NODE and step.next < step.children.count)
+						next = step.children.get(tree, step.id, step.next++);
+					if (next == NO_NODE){
+						NodeId id = step.id;
+						stack.pop_back();
+						visitor.leave(id, depth);
+						continue;
+					}
+					if (step.visited)
+						visitor.between(step.id, step.next - 1, depth);
+					step.visited = true;
+					if (visitor.enter(next, depth + 1))
+						push(next, visitor, depth + 1);
+				}
+			}
+
+		private:
+			struct Step{
+				NodeId id;
+				Children children;
+				// index of the child to look at next
+				uint32_t next;
+				// if a child was walked already
+				bool visited;
+			};
+
+			const Tree& tree;
+			std::vector<Step> stack;
+
+			// a node which was entered, leaves are left right away, and do not go on the stack
+			template<typename V>
+			void push(NodeId id, V& visitor, uint32_t depth){
+				Children children = Children::of(tree, id);
+				if (children.count == 0)
+					visitor.leave(id, depth);
+				else
+					stack.push_back({id, children, 0, false});
+			}
+	};
+
+	// prints a node per line, its children under it and indented by one more step
+	class Printer : public Visitor{
+		public:
+			Printer(const Tree& tree, FILE* out) : tree(tree), out(out){}
+
+			bool enter(NodeId id, uint32_t depth){
+				const Node& node = tree[id];
+				// past this the depth is written out instead, long chains would take the square of their length to print otherwise
+				const uint32_t MAX_INDENT = 32;
+				if (depth > MAX_INDENT)
+					fprintf(out, "%*s[%u] ", (int) MAX_INDENT * 2, "", depth);
+				else
+					fprintf(out, "%*s", (int) depth * 2, "");
+
+				switch (node.type){
+					case ELEMENT_OPERATION:
+						fprintf(out, "operation %c", node.aux);
+						break;
+					case ELEMENT_LITERAL:
+						if (node.aux == TYPE_NUM){
+							char number[32];
+							*std::to_chars(number, number + sizeof(number) - 1, tree.number(id)).ptr = '\0';
+							fprintf(out, "num %s", number);
+						}
+						else if (node.aux == TYPE_STR)
+							fprintf(out, "str \"%s\"", escape(tree.text(id)).c_str());
+						else
+							fprintf(out, "null");
+						break;
+					case ELEMENT_REF:
+						fprintf(out, "ref %s", name(node.a).c_str());
+						break;
+					case ELEMENT_FUNCTION_CALL:
+						fprintf(out, "call %s", name(node.a).c_str());
+						break;
+					case ELEMENT_SERVE:
+						fprintf(out, "serve");
+						break;
+					case ELEMENT_MACRO_DEF:
+						fprintf(out, "macro %s %s", std::string(tree.macro_type(id).name()).c_str(), name(node.a).c_str());
+						break;
+					case ELEMENT_FUNCTION_DEF:
+						{
+							Function function = tree.function(id);
+							std::string parameters;
+							for (uint32_t i = 0; i < function.parameter_count; i++){
+								if (i > 0)
+									parameters += ", ";
+								parameters += function.type(i).name();
+								parameters += " ";
+								parameters += name(function.name(i));
+								if (function.fallback(i) != NO_NODE){
+									parameters += " ";
+									parameters += tree.value(function.fallback(i));
+								}
+							}
+							fprintf(out, "func %s %s(%s)", std::string(function.ret_type.name()).c_str(), name(node.a).c_str(), parameters.c_str());
+						}
+						break;
+					default:
+						fprintf(out, "element %d", node.type);
+						break;
+				}
+				fprintf(out, " line %d\n", node.line);
+				return true;
+			}
+
+		private:
+			const Tree& tree;
+			FILE* out;
+
+			static std::string name(Symbols::Symbol symbol){
+				return std::string(Symbols::table().name(symbol));
+			}
+	};
+
+}
+
+namespace Incremental{
+
+	// the bytes [offset, offset + length) of the source are replaced with text
+	struct Edit{
+		uint32_t offset;
+		uint32_t length;
+		std::string_view text;
+	};
+
+	// replaces length items of to, from at on, with the ones of with, what comes after is moved only once
+	template<typename T>
+	void splice(std::vector<T>& to, size_t at, size_t length, const std::vector<T>& with){
+		if (with.size() > length)
+			to.insert(to.begin() + at + length, with.size() - length, T());
+		else
+			to.erase(to.begin() + at + with.size(), to.begin() + at + length);
+		std::copy(with.begin(), with.end(), to.begin() + at);
+	}
+
+	/**
+	 * a source buffer with its tokens and syntax tree, kept up to date as it is edited
+	 *
+	 * an edit re-lexes and re-parses only the top level statements it touches, they start at line starts with nothing open,
+	 * so the lexer can pick up there, the tokens and nodes of the other statements stay, moved along if the size changed
+	 *
+	 * everything is redone from scratch if the new statements leave a string or a body open, or there is an open one before them,
+	 * if the limit of errors is reached, or once the nodes of replaced statements are as many as the rest
+	 */
+	class Document{
+		public:
+			// 0 for no limit of errors
+			Document(std::string code, uint32_t max_errors = 0) : source(std::move(code)), max_errors(max_errors){
+				rebuild();
+			}
+
+			// the tokens and the tree point into the source
+			Document(const Document&) = delete;
+			Document& operator=(const Document&) = delete;
+
+			std::string_view code() const{
+				return source;
+			}
+
+			const Lexer::TokenBuffer& tokens() const{
+				return buffer;
+			}
+
+			const Parser::ParseResult& parsed() const{
+				return result;
+			}
+
+			/**
+			 * returns false if everything was redone from scratch
+			 *
+			 * an edit which reaches past the end of the source is cut short there, one which starts past it appends
+			 */
+			bool edit(const Edit& edit){
+				uint32_t offset = std::min<size_t>(edit.offset, source.size());
+				uint32_t length = std::min<size_t>(edit.length, source.size() - offset);
+				// the statement right after the replaced bytes is touched too, the new text could run into it
+				bool incremental = starts.size() > 1 and Lexer::Parallel::NEWLINE_RESETS and Lexer::Parallel::can_split();
+				uint32_t first = 0;
+				uint32_t last = 0;
+				if (incremental){
+					first = statement_at(offset);
+					last = statement_at(offset + length);
+				}
+				// where the errors are, the source they point into is about to change
+				error_offsets.clear();
+				for (const Parser::ParserError& error : result.errors.list())
+					error_offsets.push_back(error.at.data() - source.data());
+
+				Range range = incremental ? Range{first, last + 1, begin(first), begin(last + 1)} : Range{};
+				source.replace(offset, length, edit.text);
+				if (incremental and update(range, (int32_t) edit.text.size() - (int32_t) length))
+					return true;
+				rebuild();
+				return false;
+			}
+
+		private:
+			std::string source;
+			uint32_t max_errors;
+			Lexer::TokenBuffer buffer;
+			Parser::ParseResult result;
+			// the first token of every top level statement, and the number of tokens at the end
+			std::vector<uint32_t> starts;
+			// nodes of statements which were replaced, they are made void
+			uint32_t garbage = 0;
+			// the first multiline string which is never closed, where it ends depends on what comes after it
+			uint32_t unclosed = Lexer::NO_PARTNER;
+			std::vector<uint32_t> error_offsets;
+			std::vector<uint32_t> scratch;
+
+			// statements [first, last), which are the bytes [begin, end)
+			struct Range{
+				uint32_t first;
+				uint32_t last;
+				uint32_t begin;
+				uint32_t end;
+			};
+
+			// the byte the statement starts at, the line start after the newline ending the one before
+			uint32_t begin(uint32_t statement) const{
+				if (statement + 1 == starts.size())
+					return source.size();
+				uint32_t token = starts[statement];
+				return token == 0 ? 0 : buffer.offsets[token-1] + buffer.lengths[token-1];
+			}
+
+			// the statement the byte is in
+			uint32_t statement_at(uint32_t byte) const{
+				uint32_t low = 0;
+				uint32_t high = starts.size() - 1;
+				while (high - low > 1){
+					uint32_t middle = (low + high) / 2;
+					if (begin(middle) <= byte)
+						low = middle;
+					else
+						high = middle;
+				}
+				return low;
+			}
+
+			void rebuild(){
+				buffer = Lexer::tokenize(source);
+				result = Parser::_parse(buffer, false, max_errors);
+				starts.clear();
+				for (uint32_t i = 0; i < buffer.size(); i = Parser::statement_end(buffer, i))
+					starts.push_back(i);
+				starts.push_back(buffer.size());
+				garbage = 0;
+				unclosed = find_unclosed(0, buffer.size());
+			}
+
+			uint32_t find_unclosed(uint32_t from, uint32_t to) const{
+				for (uint32_t i = from; i < to; i++){
+					uint32_t other = buffer.partners[i];
+					if (buffer.type(i) == Lexer::TOKEN_MULTILINE_STRING_START and (other >= buffer.size() or buffer.partners[other] != i))
+						return i;
+				}
+				return Lexer::NO_PARTNER;
+			}
+
+			// the source is already edited, returns false if it has to be redone from scratch
+			bool update(const Range& range, int32_t delta){
+				std::string_view code = source;
+				uint32_t end = range.end + delta;
+				if (result.errors.full() or unclosed < starts[range.first])
+					return false;
+
+				// lex the statements again
+				Lexer::TokenBuffer part;
+				part.code = code;
+				Lexer::tokenize_range<false>(code.substr(0, end), range.begin, false, part);
+				Symbols::Interner& table = Symbols::table();
+				part.symbols.assign(part.size(), Symbols::NONE);
+				for (size_t i = 0; i < part.size(); i++)
+					if (part.types[i] == Lexer::TOKEN_IDENTIFIER)
+						part.symbols[i] = table.intern(part.value(i));
+
+				uint32_t first = starts[range.first];
+				uint32_t count = part.size();
+				int32_t moved = (int32_t) count - (int32_t) (starts[range.last] - first);
+				uint32_t removed = starts[range.last] - first;
+				splice(buffer.types, first, removed, part.types);
+				splice(buffer.offsets, first, removed, part.offsets);
+				splice(buffer.lengths, first, removed, part.lengths);
+				splice(buffer.symbols, first, removed, part.symbols);
+				part.partners.assign(count, Lexer::NO_PARTNER);
+				splice(buffer.partners, first, removed, part.partners);
+				buffer.code = code;
+				buffer.lines.code = code;
+				// separate simple loops, so they are vectorized
+				for (uint32_t i = first + count; i < buffer.size(); i++)
+					buffer.offsets[i] += delta;
+				if (moved != 0)
+					for (uint32_t i = first + count; i < buffer.size(); i++)
+						buffer.partners[i] += buffer.partners[i] == Lexer::NO_PARTNER ? 0 : moved;
+				Lexer::match_pairs(buffer, first, first + count);
+				// a string or a body left open would take in the statements after it
+				if (first + count < buffer.size()){
+					for (uint32_t i = first; i < first + count; i++){
+						uint32_t other = buffer.partners[i];
+						bool closed = other < buffer.size() and buffer.partners[other] == i;
+						if ((buffer.type(i) == Lexer::TOKEN_SQ_BRACKET_O or buffer.type(i) == Lexer::TOKEN_MULTILINE_STRING_START) and not closed)
+							return false;
+					}
+				}
+				if (unclosed != Lexer::NO_PARTNER and unclosed >= first + removed)
+					unclosed += moved;
+				else if (unclosed != Lexer::NO_PARTNER)
+					unclosed = find_unclosed(first, buffer.size());
+				else
+					unclosed = find_unclosed(first, first + count);
+
+				// the lines starting in the statements, and the one starting right after them
+				std::vector<uint32_t>& lines = buffer.lines.starts;
+				size_t line_at = std::upper_bound(lines.begin(), lines.end(), range.begin) - lines.begin();
+				size_t line_count = std::upper_bound(lines.begin(), lines.end(), range.end) - lines.begin() - line_at;
+				int32_t new_lines = (int32_t) part.lines.starts.size() - (int32_t) line_count;
+				splice(lines, line_at, line_count, part.lines.starts);
+				for (size_t i = line_at + part.lines.starts.size(); i < lines.size(); i++)
+					lines[i] += delta;
+
+				scratch.clear();
+				for (uint32_t i = first; i < first + count; i = Parser::statement_end(buffer, i))
+					scratch.push_back(i);
+				splice(starts, range.first, range.last - range.first, scratch);
+				for (size_t i = range.first + scratch.size(); i < starts.size(); i++)
+					starts[i] += moved;
+
+				// parse them again
+				Parser::ParseResult parsed = Parser::Reader<false>(buffer, 0, first, first + count).parse();
+				Parser::Tree& tree = result.tree;
+				tree.code = code;
+
+				// the old statements, found by where they start
+				Memory::List<const Parser::NodeId> top = tree.statements();
+				auto statement_at = [&](uint32_t byte){
+					return std::partition_point(top.begin(), top.end(), [&](Parser::NodeId id){ return tree[id].offset < byte; }) - top.begin();
+				};
+				uint32_t kept_before = statement_at(range.begin);
+				uint32_t kept_after = statement_at(range.end);
+				scratch.assign(top.begin(), top.end());
+
+				// nodes after the edit move along with their text, the ones of the old statements are not used anymore
+				for (Parser::Node& node : tree.nodes){
+					if (node.offset >= range.end){
+						node.offset += delta;
+						node.line += new_lines;
+						if (node.type == Parser::ELEMENT_LITERAL and node.flags & Parser::FLAG_IN_SOURCE)
+							node.a += delta;
+					}
+					else if (node.offset >= range.begin and node.type != Parser::ELEMENT_VOID){
+						node.type = Parser::ELEMENT_VOID;
+						garbage++;
+					}
+				}
+
+				// the new nodes go after the rest, the list of statements is made again after them
+				const Parser::Tree& from = parsed.tree;
+				tree.extra.resize(tree.top);
+				Parser::Shift shift{(uint32_t) tree.nodes.size() - 1, (uint32_t) tree.extra.size() - 1, (uint32_t) tree.strings.size()};
+				tree.nodes.insert(tree.nodes.end(), from.nodes.begin() + 1, from.nodes.end());
+				tree.extra.insert(tree.extra.end(), from.extra.begin() + 1, from.extra.begin() + from.top);
+				tree.strings += from.strings;
+				for (size_t i = shift.nodes + 1; i < tree.nodes.size(); i++)
+					Parser::rebase(tree.nodes[i], tree.extra, shift);
+
+				Memory::List<const Parser::NodeId> added = from.statements();
+				tree.top = tree.extra.size();
+				tree.extra.push_back(kept_before + added.size() + scratch.size() - kept_after);
+				tree.extra.insert(tree.extra.end(), scratch.begin(), scratch.begin() + kept_before);
+				for (Parser::NodeId id : added)
+					tree.extra.push_back(shift.node(id));
+				tree.extra.insert(tree.extra.end(), scratch.begin() + kept_after, scratch.end());
+
+				// the errors of the other statements stay, in order with the new ones
+				Parser::Diagnostics errors(max_errors);
+				Memory::List<const Parser::ParserError> old = result.errors.list();
+				for (uint32_t i = 0; i < old.size() and error_offsets[i] < range.begin; i++)
+					errors.add(old[i].line, old[i].message, code.substr(error_offsets[i], old[i].at.size()));
+				for (const Parser::ParserError& error : parsed.errors.list())
+					errors.add(error.line, error.message, error.at);
+				for (uint32_t i = 0; i < old.size(); i++)
+					if (error_offsets[i] >= range.end)
+						errors.add(old[i].line + new_lines, old[i].message, code.substr(error_offsets[i] + delta, old[i].at.size()));
+				// the parser would have stopped somewhere in between
+				if (errors.full())
+					return false;
+				result.errors = std::move(errors);
+				result.successful = result.errors.empty();
+
+				return garbage <= tree.nodes.size() / 2;
+			}
+	};
+
+}
+
+namespace Source{
+
+	/**
+	 * a read only input file
+	 *
+	 * regular files are memory mapped, so the lexer reads straight from the page cache,
+	 * stdin ("-"), pipes and anything else that cannot be mapped is read into a buffer
+	 */
+	class File{
+		public:
+			File() = default;
+			File(const File&) = delete;
+			File& operator=(const File&) = delete;
+
+			~File(){
+				#ifdef CFUSS_POSIX
+				if (mapped != nullptr)
+					munmap((void*) mapped, mapped_size);
+				#endif
+			}
+
+			// returns false if the file could not be opened or read
+			bool open(const std::string& path){
+				#ifdef CFUSS_POSIX
+				int fd = path == "-" ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+				if (fd < 0)
+					return false;
+				bool ok = load(fd);
+				if (fd != STDIN_FILENO)
+					::close(fd);
+				return ok;
+				#else
+				if (path == "-"){
+					buffer.assign(std::istreambuf_iterator<char>(std::cin), {});
+					return true;
+				}
+				std::ifstream input(path, std::ios::binary);
+				if (!input.is_open())
+					return false;
+				buffer.assign(std::istreambuf_iterator<char>(input), {});
+				return true;
+				#endif
+			}
+
+			// stays valid for as long as the file object is alive
+			std::string_view code() const{
+				if (mapped != nullptr)
+					return std::string_view(mapped, mapped_size);
+				return buffer;
+			}
+
+		private:
+			const char* mapped = nullptr;
+			size_t mapped_size = 0;
+			std::string buffer;
+
+			#ifdef CFUSS_POSIX
+			bool load(int fd){
+				struct stat info;
+				if (fstat(fd, &info) != 0)
+					return false;
+				if (S_ISREG(info.st_mode) and info.st_size > 0){
+					void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (map != MAP_FAILED){
+						// the lexer goes through it front to back exactly once
+						madvise(map, info.st_size, MADV_SEQUENTIAL);
+						mapped = (const char*) map;
+						mapped_size = info.st_size;
+						return true;
+					}
+				}
+				// buffered fallback, the size of pipes is not known upfront
+				size_t chunk = S_ISREG(info.st_mode) ? info.st_size + 1 : 1 << 16;
+				for (;;){
+					size_t used = buffer.size();
+					buffer.resize(used + chunk);
+					ssize_t got = ::read(fd, &buffer[used], chunk);
+					if (got < 0){
+						buffer.clear();
+						return false;
+					}
+					buffer.resize(used + got);
+					if (got == 0)
+						return true;
+					if (chunk < 1 << 24)
+						chunk *= 2;
+				}
+			}
+			#endif
+	};
+
+}
+
+namespace Output{
+
+	/**
+	 * a file generated code is written to, through a fixed buffer which goes out with write(2) whenever it is full
+	 *
+	 * the output is never in memory as a whole, and the buffer is allocated once, it is kept when the sink is opened again,
+	 * a sink can also collect what is written in a string, for parts of the output which are written on several threads
+	 */
+	class Sink{
+		public:
+			static const size_t BUFFER_SIZE = 1 << 20;
+
+			Sink() = default;
+			Sink(const Sink&) = delete;
+			Sink& operator=(const Sink&) = delete;
+
+			~Sink(){
+				close();
+			}
+
+			// returns false if the file could not be created
+			bool open(const std::string& path){
+				close();
+				failed = false;
+				if (buffer == nullptr)
+					buffer.reset(new char[BUFFER_SIZE]);
+				data = buffer.get();
+				capacity = BUFFER_SIZE;
+				#ifdef CFUSS_POSIX
+				fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+				return fd >= 0;
+				#else
+				file = fopen(path.c_str(), "wb");
+				return file != nullptr;
+				#endif
+			}
+
+			#ifdef CFUSS_POSIX
+			// a file descriptor which is open already, like the end of a pipe, it is closed with the sink
+			void open(int fd){
+				close();
+				failed = false;
+				if (buffer == nullptr)
+					buffer.reset(new char[BUFFER_SIZE]);
+				data = buffer.get();
+				capacity = BUFFER_SIZE;
+				this->fd = fd;
+			}
+			#endif
+
+			// what is written goes to the end of text, which grows as needed, it has all of it once the sink is closed
+			void collect(std::string& text){
+				close();
+				failed = false;
+				used = text.size();
+				text.resize(std::max<size_t>(text.size() * 2, 4096));
+				memory = &text;
+				data = &text[0];
+				capacity = text.size();
+			}
+
+			// writes out what is left, returns false if anything could not be written
+			bool close(){
+				if (memory != nullptr){
+					memory->resize(used);
+					memory = nullptr;
+					used = 0;
+				}
+				flush();
+				data = nullptr;
+				capacity = 0;
+				#ifdef CFUSS_POSIX
+				if (fd >= 0 and ::close(fd) != 0)
+					failed = true;
+				fd = -1;
+				#else
+				if (file != nullptr and fclose(file) != 0)
+					failed = true;
+				file = nullptr;
+				#endif
+				return not failed;
+			}
+
+			void put(std::string_view text){
+				if (text.size() <= capacity - used){
+					std::memcpy(data + used, text.data(), text.size());
+					used += text.size();
+					return;
+				}
+				while (not text.empty()){
+					if (used == capacity)
+						flush();
+					size_t part = std::min(text.size(), capacity - used);
+					std::memcpy(data + used, text.data(), part);
+					used += part;
+					text.remove_prefix(part);
+				}
+			}
+
+			void put(char c){
+				if (used == capacity)
+					flush();
+				data[used++] = c;
+			}
+
+			// in decimal
+			void number(long long value){
+				// enough for any long long
+				if (capacity - used < 24)
+					flush();
+				used = std::to_chars(data + used, data + capacity, value).ptr - data;
+			}
+
+			// the shortest decimal which reads back as the same double, with a . or an exponent, so C takes it as a double too
+			void real(double value){
+				// enough for any double, and the .0
+				if (capacity - used < 32)
+					flush();
+				char* start = data + used;
+				char* end = std::to_chars(start, data + capacity, value).ptr;
+				if (std::find_if(start, end, [](char c){ return c == '.' or c == 'e'; }) == end){
+					*end++ = '.';
+					*end++ = '0';
+				}
+				used = end - data;
+			}
+
+		private:
+			std::unique_ptr<char[]> buffer;
+			// where the output goes before it is written out, the buffer, or the string of a sink writing to memory
+			char* data = nullptr;
+			size_t capacity = 0;
+			size_t used = 0;
+			std::string* memory = nullptr;
+			bool failed = false;
+			#ifdef CFUSS_POSIX
+			int fd = -1;
+			#else
+			FILE* file = nullptr;
+			#endif
+
+			// makes room in data
+			void flush(){
+				if (memory != nullptr){
+					memory->resize(capacity * 2);
+					data = &(*memory)[0];
+					capacity = memory->size();
+					return;
+				}
+				const char* at = data;
+				size_t left = used;
+				used = 0;
+				#ifdef CFUSS_POSIX
+				if (fd < 0)
+					return;
+				while (left > 0 and not failed){
+					ssize_t written = ::write(fd, at, left);
+					if (written < 0 and errno == EINTR)
+						continue;
+					if (written <= 0)
+						failed = true;
+					else{
+						at += written;
+						left -= written;
+					}
+				}
+				#else
+				if (file != nullptr and left > 0 and fwrite(at, 1, left, file) != left)
+					failed = true;
+				#endif
+			}
+	};
+
+}
+
+namespace Cache{
+
+	/**
+	 * the syntax tree of a source file, stored in the cache directory under a hash of its path, so an unchanged file
+	 * does not have to be parsed again, and the directory of the source is left alone
+	 *
+	 * the file is a header followed by the arrays of the tree as they are in memory, 4 byte aligned ones first,
+	 * so it can be used straight from a mapping, and the names of the symbols, interned again in the same order when loading
+	 *
+	 * only trees of sources without errors are stored
+	 */
+	const char MAGIC[4] = {'F', 'S', 'S', 'C'};
+	// changes with the layout of the file or of the tree
+	const uint32_t VERSION = 3;
+
+	// tells builds of the compiler apart, so a tree cached by one is never read by another, whatever VERSION says
+	const char BUILD[] = __DATE__ " " __TIME__
+	#ifdef __VERSION__
+		" " __VERSION__
+	#endif
+	;
+
+	struct Header{
+		char magic[4];
+		uint32_t version;
+		// hash of BUILD
+		uint64_t build;
+		// of the source the tree was parsed from, and its size
+		uint64_t hash;
+		uint64_t source_size;
+		// a build with another layout of the nodes does not read them
+		uint32_t node_size;
+		uint32_t nodes;
+		uint32_t extra;
+		uint32_t top;
+		// bytes
+		uint32_t strings;
+		// symbols after NONE, and the bytes of their names
+		uint32_t symbols;
+		uint32_t names;
+		uint32_t padding;
+	};
+
+	// 64 bit hash of the contents, 8 bytes at a time, to tell versions of a file apart
+	uint64_t hash(std::string_view data){
+		const uint64_t K = 0x9E3779B97F4A7C15ull;
+		uint64_t h = data.size() * K;
+		auto mix = [&](uint64_t word){
+			h = (h ^ word) * K;
+			h ^= h >> 29;
+		};
+		size_t i = 0;
+		for (; i + 8 <= data.size(); i += 8){
+			uint64_t word;
+			std::memcpy(&word, data.data() + i, 8);
+			mix(word);
+		}
+		if (i < data.size()){
+			uint64_t word = 0;
+			std::memcpy(&word, data.data() + i, data.size() - i);
+			mix(word);
+		}
+		h ^= h >> 32;
+		return h * K;
+	}
+
+	/**
+	 * if every index in the tree points inside of it, so nothing going over it can read past the end of an array
+	 *
+	 * a cache file is only checked against the source it belongs to, what the nodes say has to be checked on its own,
+	 * children come before their parents, like in a tree from the parser, so there are no cycles either
+	 */
+	bool valid(const Parser::Tree& tree, size_t symbols){
+		using namespace Parser;
+		const std::vector<uint32_t>& extra = tree.extra;
+		// a list at that index, with items below limit
+		auto list = [&](uint32_t at, uint32_t limit){
+			if (at >= extra.size() or extra[at] > extra.size() - at - 1)
+				return false;
+			for (uint32_t i = 1; i <= extra[at]; i++)
+				if (extra[at + i] >= limit)
+					return false;
+			return true;
+		};
+		auto type = [&](uint32_t packed){
+			return packed & ValType::STRUCT_BIT ? (packed & ~ValType::STRUCT_BIT) < symbols : packed <= TYPE_STR;
+		};
+		auto symbol = [&](uint32_t symbol){
+			return symbol != Symbols::NONE and symbol < symbols;
+		};
+
+		int lines = std::count(tree.code.begin(), tree.code.end(), '\n') + 1;
+		if (tree.nodes.empty() or tree.nodes[0].type != ELEMENT_VOID or extra.empty() or extra[0] != 0)
+			return false;
+		if (not list(tree.top, tree.nodes.size()))
+			return false;
+		for (NodeId id = 1; id < tree.nodes.size(); id++){
+			const Node& node = tree.nodes[id];
+			if (node.offset > tree.code.size() or node.length > tree.code.size() - node.offset or node.line < 1 or node.line > lines)
+				return false;
+			switch (node.type){
+				case ELEMENT_OPERATION:
+					if (node.a >= id or node.b >= id)
+						return false;
+					break;
+				case ELEMENT_LITERAL:
+					if (node.aux == TYPE_STR){
+						size_t size = node.flags & FLAG_IN_SOURCE ? tree.code.size() : tree.strings.size();
+						if (node.a > size or node.b > size - node.a)
+							return false;
+					}
+					else if (node.aux != TYPE_NUM and node.aux != TYPE_VOID)
+						return false;
+					break;
+				case ELEMENT_REF:
+					if (not symbol(node.a))
+						return false;
+					break;
+				case ELEMENT_FUNCTION_CALL:
+					if (not symbol(node.a) or not list(node.b, id))
+						return false;
+					break;
+				case ELEMENT_SERVE:
+					if (node.a >= id)
+						return false;
+					break;
+				case ELEMENT_MACRO_DEF:
+					if (not symbol(node.a) or (uint64_t) node.b + 1 >= extra.size() or not type(extra[node.b]) or extra[node.b + 1] >= id)
+						return false;
+					break;
+				case ELEMENT_FUNCTION_DEF:
+					{
+						if (not symbol(node.a) or (uint64_t) node.b + 2 >= extra.size() or not type(extra[node.b]) or not list(extra[node.b + 1], id))
+							return false;
+						uint32_t count = extra[node.b + 2];
+						if (count > (extra.size() - node.b - 3) / 3)
+							return false;
+						for (uint32_t i = 0; i < count; i++){
+							const uint32_t* parameter = extra.data() + node.b + 3 + i * 3;
+							if (not symbol(parameter[0]) or not type(parameter[1]) or parameter[2] >= id)
+								return false;
+							if (parameter[2] != NO_NODE and tree.nodes[parameter[2]].type != ELEMENT_LITERAL)
+								return false;
+						}
+					}
+					break;
+				// the parser makes no other nodes
+				default:
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// $XDG_CACHE_HOME/cfuss, or ~/.cache/cfuss, empty if neither is set, the object cache goes there as well
+	std::string directory(){
+		const char* cache = std::getenv("XDG_CACHE_HOME");
+		if (cache != nullptr and *cache != '\0')
+			return std::string(cache) + "/cfuss";
+		const char* home = std::getenv("HOME");
+		if (home == nullptr)
+			home = std::getenv("USERPROFILE");
+		if (home != nullptr and *home != '\0')
+			return std::string(home) + "/.cache/cfuss";
+		return "";
+	}
+
+	// where the tree of a source file is cached in directory, named by its absolute path, so every source has one
+	std::string path(const std::string& directory, const std::string& source){
+		std::error_code error;
+		std::string absolute = std::filesystem::absolute(source, error).lexically_normal().string();
+		char name[32];
+		snprintf(name, sizeof(name), "/%016llx.fussc", (unsigned long long) hash(error ? source : absolute));
+		return directory + name;
+	}
+
+	// returns false if the cache is missing, broken or for other contents than code
+	bool load(const std::string& path, std::string_view code, Parser::Tree& tree){
+		Source::File file;
+		if (not file.open(path))
+			return false;
+		std::string_view data = file.code();
+		if (data.size() < sizeof(Header))
+			return false;
+		Header header;
+		std::memcpy(&header, data.data(), sizeof(Header));
+		if (
+			   std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+			or header.version != VERSION
+			or header.build != hash(BUILD)
+			or header.node_size != sizeof(Parser::Node)
+			or header.source_size != code.size()
+			or header.hash != hash(code)
+		)
+			return false;
+		uint64_t size = sizeof(Header)
+			+ (uint64_t) header.nodes * sizeof(Parser::Node)
+			+ (uint64_t) header.extra * sizeof(uint32_t)
+			+ (uint64_t) header.symbols * sizeof(uint32_t)
+			+ header.strings + header.names;
+		if (size != data.size() or header.nodes == 0 or header.top >= header.extra)
+			return false;
+
+		const char* at = data.data() + sizeof(Header);
+		const Parser::Node* nodes = (const Parser::Node*) at;
+		at += header.nodes * sizeof(Parser::Node);
+		const uint32_t* extra = (const uint32_t*) at;
+		at += header.extra * sizeof(uint32_t);
+		const uint32_t* lengths = (const uint32_t*) at;
+		at += header.symbols * sizeof(uint32_t);
+		const char* strings = at;
+		at += header.strings;
+
+		/**
+		 * the nodes refer to symbols by id, the names have to get the same ones again, so the names interned already
+		 * have to be the first ones of the file, and the others new and different from each other,
+		 * everything is checked before anything is interned, a broken file leaves the table as it was
+		 */
+		Symbols::Interner& table = Symbols::table();
+		std::vector<std::string_view> names(header.symbols);
+		uint64_t names_size = 0;
+		for (uint32_t i = 0; i < header.symbols; i++){
+			names_size += lengths[i];
+			if (names_size > header.names)
+				return false;
+			names[i] = std::string_view(at, lengths[i]);
+			at += lengths[i];
+			if (table.find(names[i]) != (i + 1 < table.size() ? i + 1 : Symbols::NONE))
+				return false;
+		}
+		std::vector<std::string_view> added(names.begin() + std::min<size_t>(table.size() - 1, names.size()), names.end());
+		std::sort(added.begin(), added.end());
+		if (std::adjacent_find(added.begin(), added.end()) != added.end())
+			return false;
+
+		tree.code = code;
+		tree.nodes.assign(nodes, nodes + header.nodes);
+		tree.extra.assign(extra, extra + header.extra);
+		tree.strings.assign(strings, header.strings);
+		tree.top = header.top;
+		if (not valid(tree, header.symbols + 1)){
+			tree = Parser::Tree();
+			return false;
+		}
+		for (std::string_view name : names)
+			table.intern(name);
+		return true;
+	}
+
+	// best effort, a cache which cannot be written is not an error
+	void store(const std::string& path, std::string_view code, const Parser::Tree& tree){
+		Symbols::Interner& table = Symbols::table();
+		Header header = {
+			{MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3]}, VERSION, hash(BUILD),
+			hash(code), code.size(),
+			sizeof(Parser::Node), (uint32_t) tree.nodes.size(), (uint32_t) tree.extra.size(), tree.top,
+			(uint32_t) tree.strings.size(), (uint32_t) table.size() - 1, 0, 0
+		};
+		std::vector<uint32_t> lengths;
+		for (Symbols::Symbol symbol = 1; symbol < table.size(); symbol++){
+			lengths.push_back(table.name(symbol).size());
+			header.names += lengths.back();
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+		// written next to it and moved over it, so a reader never sees half of it
+		std::string temporary = path + ".tmp";
+		FILE* file = fopen(temporary.c_str(), "wb");
+		if (file == nullptr)
+			return;
+		bool ok = fwrite(&header, sizeof(Header), 1, file) == 1;
+		// copied field by field into zeroed nodes first, so the padding between the fields is the same in every file
+		const size_t CHUNK = 4096;
+		std::unique_ptr<Parser::Node[]> zeroed(new Parser::Node[CHUNK]);
+		for (size_t start = 0; ok and start < tree.nodes.size(); start += CHUNK){
+			size_t count = std::min(CHUNK, tree.nodes.size() - start);
+			std::memset((void*) zeroed.get(), 0, count * sizeof(Parser::Node));
+			for (size_t i = 0; i < count; i++){
+				const Parser::Node& node = tree.nodes[start + i];
+				Parser::Node& copy = zeroed[i];
+				copy.type = node.type;
+				copy.aux = node.aux;
+				copy.flags = node.flags;
+				copy.line = node.line;
+				copy.offset = node.offset;
+				copy.length = node.length;
+				copy.a = node.a;
+				copy.b = node.b;
+			}
+			ok = fwrite(zeroed.get(), sizeof(Parser::Node), count, file) == count;
+		}
+		ok = ok
+			and fwrite(tree.extra.data(), sizeof(uint32_t), tree.extra.size(), file) == tree.extra.size()
+			and fwrite(lengths.data(), sizeof(uint32_t), lengths.size(), file) == lengths.size()
+			and fwrite(tree.strings.data(), 1, tree.strings.size(), file) == tree.strings.size();
+		for (Symbols::Symbol symbol = 1; ok and symbol < table.size(); symbol++)
+			ok = fwrite(table.name(symbol).data(), 1, table.name(symbol).size(), file) == table.name(symbol).size();
+		ok = fclose(file) == 0 and ok;
+		// rename replaces the file in one go on POSIX, elsewhere it does not replace it at all
+		#ifndef CFUSS_POSIX
+		std::remove(path.c_str());
+		#endif
+		if (not ok or std::rename(temporary.c_str(), path.c_str()) != 0)
+			std::remove(temporary.c_str());
+	}
+
+}
+
+namespace Generator{
+
+	using Parser::Node;
+	using Parser::NodeId;
+	using Parser::NO_NODE;
+	using Parser::Tree;
+
+	/**
+	 * FuSS as C:
+	 *
+	 *     num                    double, comparisons and logic give 1 or 0
+	 *     str                    const char*, + of two of them makes a new one, which is never freed
+	 *     null                   0
+	 *     static macro           #define, after the prototypes of all functions
+	 *     static func            a function, all of them are declared upfront, so they can be called before their declaration,
+	 *                            one without a body anywhere is external, and keeps its name, so C functions can be declared
+	 *     top level statements   main, in the order they are in, a top level serve of a num is the exit code
+	 *
+	 * other names get a prefix for what they are, f_ for functions, m_ for macros and p_ for parameters, so they cannot clash with C,
+	 * names C does not allow go by the id of their symbol instead
+	 */
+	const char PRELUDE[] = R"(#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef double num;
+typedef const char* str;
+
+static str fuss_concat(str a, str b){
+	size_t left = strlen(a), right = strlen(b);
+	char* both = (char*) malloc(left + right + 1);
+	memcpy(both, a, left);
+	memcpy(both + left, b, right + 1);
+	return both;
+}
+
+)";
+
+	// type of an expression which is wrong, what is wrong was reported already, so it is not reported again for everything around it
+	const uint8_t TYPE_INVALID = 0xff;
+
+	// how tightly C holds on to the operands of an operator, higher is tighter
+	enum Precedence{
+		PRECEDENCE_OR = 1,
+		PRECEDENCE_AND,
+		PRECEDENCE_EQUALITY,
+		PRECEDENCE_RELATIONAL,
+		PRECEDENCE_ADDITIVE,
+		PRECEDENCE_MULTIPLICATIVE,
+		PRECEDENCE_UNARY,
+		// calls, names and literals
+		PRECEDENCE_PRIMARY,
+	};
+
+	/**
+	 * a binary operator in C, written as open, the left operand, middle, the right operand and close
+	 *
+	 * infix ones only have a middle, the others are calls and have PRECEDENCE_PRIMARY, their operands never need brackets
+	 */
+	struct Operator{
+		char op;
+		// of both operands
+		uint8_t operands;
+		uint8_t type;
+		Precedence precedence;
+		std::string_view open;
+		std::string_view middle;
+		std::string_view close;
+	};
+
+	const Operator OPERATORS[] = {
+		{'+', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_ADDITIVE,       "", " + ", ""},
+		{'-', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_ADDITIVE,       "", " - ", ""},
+		{'*', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_MULTIPLICATIVE, "", " * ", ""},
+		// comparisons give an int in C, two of them would be divided as integers
+		{':', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_MULTIPLICATIVE, "", " / (num) ", ""},
+		{'%', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_PRIMARY,        "fmod(", ", ", ")"},
+		{'<', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_RELATIONAL,     "", " < ", ""},
+		{'>', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_RELATIONAL,     "", " > ", ""},
+		{'=', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_EQUALITY,       "", " == ", ""},
+		{'&', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_AND,            "", " && ", ""},
+		{'|', Parser::TYPE_NUM, Parser::TYPE_NUM, PRECEDENCE_OR,             "", " || ", ""},
+		{'+', Parser::TYPE_STR, Parser::TYPE_STR, PRECEDENCE_PRIMARY,        "fuss_concat(", ", ", ")"},
+		{'=', Parser::TYPE_STR, Parser::TYPE_NUM, PRECEDENCE_PRIMARY,        "(strcmp(", ", ", ") == 0)"},
+	};
+
+	// nullptr if op does not take two operands of the type
+	const Operator* binary(char op, uint8_t operands){
+		// by type of the operands and operator, it is looked up a few times for every operation written out
+		static const auto table = []{
+			std::array<std::array<const Operator*, 128>, 3> table{};
+			for (const Operator& candidate : OPERATORS)
+				table[candidate.operands][candidate.op] = &candidate;
+			return table;
+		}();
+		if (operands >= table.size() or (unsigned char) op >= 128)
+			return nullptr;
+		return table[operands][op];
+	}
+
+	std::string type_name(uint8_t type){
+		return std::string(Parser::ValType((Parser::_ValType) type).name());
+	}
+
+	// if C allows the name as it is
+	bool c_name(std::string_view name){
+		if (name.empty() or (name[0] >= '0' and name[0] <= '9'))
+			return false;
+		for (char c : name)
+			if (not (c == '_' or (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9')))
+				return false;
+		return true;
+	}
+
+	// the text as a C string literal
+	void string(Output::Sink& out, std::string_view text){
+		out.put('"');
+		size_t start = 0;
+		for (size_t i = 0; i < text.size(); i++){
+			unsigned char c = text[i];
+			// ? because of trigraphs
+			if (c >= ' ' and c < 0x7f and c != '"' and c != '\\' and c != '?')
+				continue;
+			out.put(text.substr(start, i - start));
+			start = i + 1;
+			switch (c){
+				case '\n':
+					out.put("\\n");
+					break;
+				case '\t':
+					out.put("\\t");
+					break;
+				case '"':
+				case '\\':
+				case '?':
+					out.put('\\');
+					out.put((char) c);
+					break;
+				default:
+					{
+						// always three digits, so a digit after it is not taken as a part of it
+						char octal[] = {'\\', (char) ('0' + (c >> 6)), (char) ('0' + ((c >> 3) & 7)), (char) ('0' + (c & 7))};
+						out.put(std::string_view(octal, sizeof(octal)));
+					}
+					break;
+			}
+		}
+		out.put(text.substr(start));
+		out.put('"');
+	}
+
+	namespace Parallel{
+		// below this many nodes of functions the threads cost more than they save
+		const size_t MIN_NODES = 1 << 16;
+		// about this many nodes of functions go into a range, which is written out by one thread
+		const uint32_t RANGE_NODES = 1 << 12;
+		// ranges per thread in a wave, so a long function does not hold up everyone else
+		const int RANGES_PER_THREAD = 4;
+	}
+
+	/**
+	 * checks a whole tree, and writes it out as C
+	 *
+	 * both go over it with a Parser::Walker, so no depth of expressions is too much for them,
+	 * what they keep besides the tree is a byte per node for its type, and what is on the path to the current node
+	 */
+	class Program{
+		public:
+			// the functions are written out on pool, or on the shared one if it is null
+			Program(const Tree& tree, uint32_t max_errors = 0, Threads::Pool* pool = nullptr) :
+				tree(tree), diagnostics(max_errors), symbols(Symbols::table().size()), scope(tree, symbols), pool(pool){
+				functions.assign(symbols, NO_NODE);
+				macros.assign(symbols, NO_NODE);
+				types.assign(tree.nodes.size(), TYPE_INVALID);
+				valid.reserve(symbols);
+				for (Symbols::Symbol symbol = 0; symbol < symbols; symbol++)
+					valid.push_back(c_name(Symbols::table().name(symbol)));
+			}
+
+			// checks the names and the types, returns false if anything is wrong, see errors
+			bool check(){
+				// functions can be called before they are declared, so the declarations are gathered first
+				for (NodeId id : tree.statements()){
+					const Node& node = tree[id];
+					if (node.type == Parser::ELEMENT_FUNCTION_DEF){
+						NodeId& known = functions[node.a];
+						if (known != NO_NODE and has_body(known) and has_body(id))
+							error(id, "Function \"" + name(node.a) + "\" is defined more than once");
+						else if (known == NO_NODE or has_body(id))
+							known = id;
+					}
+					else if (node.type == Parser::ELEMENT_MACRO_DEF){
+						if (macros[node.a] != NO_NODE)
+							error(id, "Macro \"" + name(node.a) + "\" is defined more than once");
+						else
+							macros[node.a] = id;
+					}
+				}
+				for (NodeId id : tree.statements()){
+					const Node& node = tree[id];
+					if (node.type == Parser::ELEMENT_FUNCTION_DEF and functions[node.a] == id and not has_body(id) and not c_name(name(node.a)))
+						error(id, "Function \"" + name(node.a) + "\" has no body, and C cannot call it by its name");
+				}
+
+				Checker checker(*this);
+				for (NodeId id : tree.statements()){
+					if (diagnostics.full())
+						break;
+					scope.walker.walk(id, checker);
+				}
+				return diagnostics.empty();
+			}
+
+			// for a tree which passed check
+			void emit(Output::Sink& out){
+				declarations(out);
+				std::vector<Definition> all = bodies();
+				unit(out, {all.data(), (uint32_t) all.size()}, true);
+			}
+
+			// a function with a body
+			struct Definition{
+				NodeId id;
+				// about how many nodes it has
+				uint32_t nodes;
+			};
+
+			// the functions with a body, in source order
+			std::vector<Definition> bodies() const{
+				std::vector<Definition> found;
+				// the nodes of a statement come right before it
+				NodeId previous = 0;
+				for (NodeId id : tree.statements()){
+					if (tree[id].type == Parser::ELEMENT_FUNCTION_DEF and functions[tree[id].a] == id and has_body(id))
+						found.push_back({id, id - previous});
+					previous = id;
+				}
+				return found;
+			}
+
+			// splits the functions into at most count ranges, in order, with about as many nodes each
+			static std::vector<Memory::List<const Definition>> split(const std::vector<Definition>& all, int count){
+				uint64_t total = 0;
+				for (const Definition& definition : all)
+					total += definition.nodes;
+				std::vector<Memory::List<const Definition>> ranges;
+				uint32_t start = 0;
+				uint64_t nodes = 0;
+				for (uint32_t i = 0; i < all.size(); i++){
+					nodes += all[i].nodes;
+					// the range ends once the nodes so far reach its share of all of them
+					if (nodes * count >= total * (ranges.size() + 1) or i + 1 == all.size()){
+						ranges.push_back({all.data() + start, i + 1 - start});
+						start = i + 1;
+					}
+				}
+				return ranges;
+			}
+
+			// the prelude, the prototypes and the macros, what every translation unit needs
+			void declarations(Output::Sink& out){
+				Emitter emitter(*this, scope, out);
+				out.put(PRELUDE);
+				for (NodeId id : tree.statements())
+					if (tree[id].type == Parser::ELEMENT_FUNCTION_DEF and functions[tree[id].a] == id){
+						header(out, id);
+						out.put(";\n");
+					}
+				out.put('\n');
+
+				bool defined = false;
+				for (NodeId id : tree.statements())
+					if (tree[id].type == Parser::ELEMENT_MACRO_DEF){
+						out.put("#define ");
+						symbol(out, 'm', tree[id].a);
+						out.put(" (");
+						scope.walker.walk(tree.macro_body(id), emitter);
+						out.put(")\n");
+						defined = true;
+					}
+				if (defined)
+					out.put('\n');
+			}
+
+			// the definitions of functions, and main if it is asked for, for after the declarations or something including them
+			void unit(Output::Sink& out, Memory::List<const Definition> functions, bool with_main){
+				Emitter emitter(*this, scope, out);
+				definitions(emitter, functions);
+				if (not with_main)
+					return;
+
+				out.put("int main(void){\n");
+				for (NodeId id : tree.statements())
+					if (tree[id].type != Parser::ELEMENT_FUNCTION_DEF and tree[id].type != Parser::ELEMENT_MACRO_DEF)
+						statement(emitter, id);
+				out.put("\treturn 0;\n}\n");
+			}
+
+			const Parser::Diagnostics& errors() const{
+				return diagnostics;
+			}
+
+		private:
+			// what changes on the way through the tree, every thread writing out functions has its own
+			struct Scope{
+				Parser::Walker walker;
+				// the function the statements are in, NO_NODE at the top level
+				NodeId function = NO_NODE;
+				// by symbol, the parameter of the function with that name, its index + 1, 0 for none
+				std::vector<uint32_t> parameters;
+
+				Scope(const Tree& tree, size_t symbols) : walker(tree), parameters(symbols, 0){}
+			};
+
+			const Tree& tree;
+			Parser::Diagnostics diagnostics;
+			size_t symbols;
+			// of checking, and of what is written out on the calling thread
+			Scope scope;
+			Threads::Pool* pool;
+			// by symbol, the declaration of the function with a body if there is one, and the macro
+			std::vector<NodeId> functions;
+			std::vector<NodeId> macros;
+			// by node
+			std::vector<uint8_t> types;
+			// by symbol, if C takes the name as it is
+			std::vector<bool> valid;
+
+			// works out the types, the children of a node are done by the time the walk leaves it
+			struct Checker : Parser::Visitor{
+				Program& program;
+
+				Checker(Program& program) : program(program){}
+
+				bool enter(NodeId id, uint32_t depth){
+					uint8_t type = program.tree[id].type;
+					if (type != Parser::ELEMENT_FUNCTION_DEF and type != Parser::ELEMENT_MACRO_DEF)
+						return true;
+					if (depth > 0){
+						program.error(id, "Functions and macros can only be declared at the top level");
+						return false;
+					}
+					if (type == Parser::ELEMENT_FUNCTION_DEF){
+						program.check_parameters(id);
+						program.enter_function(program.scope, id);
+					}
+					return true;
+				}
+
+				void leave(NodeId id, uint32_t depth){
+					program.types[id] = program.type_of(id);
+					if (program.tree[id].type == Parser::ELEMENT_FUNCTION_DEF)
+						program.leave_function(program.scope);
+				}
+			};
+
+			// writes out expressions, in brackets where C would read them differently without
+			struct Emitter : Parser::Visitor{
+				const Program& program;
+				Scope& scope;
+				Output::Sink& out;
+				// for the nodes on the path to the current one, if they were put in brackets
+				std::vector<std::pair<NodeId, bool>> path;
+
+				Emitter(const Program& program, Scope& scope, Output::Sink& out) : program(program), scope(scope), out(out){}
+
+				bool enter(NodeId id, uint32_t depth){
+					const Tree& tree = program.tree;
+					const Node& node = tree[id];
+					NodeId parent = depth > 0 ? path[depth - 1].first : NO_NODE;
+					bool wrapped = parent != NO_NODE and program.needs_brackets(parent, id);
+					path.resize(depth + 1);
+					path[depth] = {id, wrapped};
+					if (wrapped)
+						out.put('(');
+
+					switch (node.type){
+						case Parser::ELEMENT_LITERAL:
+							program.literal(out, id);
+							break;
+						case Parser::ELEMENT_REF:
+							if (scope.function != NO_NODE and scope.parameters[node.a] != 0)
+								program.symbol(out, 'p', node.a);
+							else
+								program.symbol(out, 'm', node.a);
+							break;
+						case Parser::ELEMENT_OPERATION:
+							if (node.a == NO_NODE){
+								// "- -" and not "--"
+								bool after_minus = parent != NO_NODE and not wrapped and tree[parent].type == Parser::ELEMENT_OPERATION and tree[parent].a == NO_NODE;
+								out.put(after_minus ? " -" : "-");
+							}
+							else
+								out.put(program.operator_of(id)->open);
+							break;
+						case Parser::ELEMENT_FUNCTION_CALL:
+							program.function_name(out, node.a);
+							out.put('(');
+							break;
+						default:
+							break;
+					}
+					return true;
+				}
+
+				void between(NodeId id, uint32_t i, uint32_t depth){
+					if (program.tree[id].type == Parser::ELEMENT_OPERATION)
+						out.put(program.operator_of(id)->middle);
+					else
+						out.put(", ");
+				}
+
+				void leave(NodeId id, uint32_t depth){
+					const Node& node = program.tree[id];
+					if (node.type == Parser::ELEMENT_OPERATION and node.a != NO_NODE)
+						out.put(program.operator_of(id)->close);
+					else if (node.type == Parser::ELEMENT_FUNCTION_CALL){
+						// the parameters which were left out get their defaults
+						Parser::Function declaration = program.tree.function(program.functions[node.a]);
+						for (uint32_t i = program.tree.list(node.b).size(); i < declaration.parameter_count; i++){
+							if (i > 0)
+								out.put(", ");
+							program.literal(out, declaration.fallback(i));
+						}
+						out.put(')');
+					}
+					if (path[depth].second)
+						out.put(')');
+				}
+			};
+
+			void error(NodeId id, std::string_view message){
+				diagnostics.add(tree[id].line, message, tree.value(id));
+			}
+
+			std::string name(Symbols::Symbol symbol) const{
+				return std::string(Symbols::table().name(symbol));
+			}
+
+			bool has_body(NodeId function) const{
+				// a function without one shares the empty list
+				return tree.extra[tree[function].b + 1] != 0;
+			}
+
+			void enter_function(Scope& scope, NodeId id) const{
+				scope.function = id;
+				Parser::Function declaration = tree.function(id);
+				for (uint32_t i = declaration.parameter_count; i-- > 0;)
+					scope.parameters[declaration.name(i)] = i + 1;
+			}
+
+			void leave_function(Scope& scope) const{
+				Parser::Function declaration = tree.function(scope.function);
+				for (uint32_t i = 0; i < declaration.parameter_count; i++)
+					scope.parameters[declaration.name(i)] = 0;
+				scope.function = NO_NODE;
+			}
+
+			void check_parameters(NodeId id){
+				Parser::Function declaration = tree.function(id);
+				for (uint32_t i = 0; i < declaration.parameter_count; i++){
+					Parser::ValType type = declaration.type(i);
+					NodeId fallback = declaration.fallback(i);
+					for (uint32_t j = 0; j < i; j++)
+						if (declaration.name(j) == declaration.name(i))
+							error(id, "Parameter \"" + name(declaration.name(i)) + "\" is declared more than once");
+					if (type.type == Parser::TYPE_VOID)
+						error(id, "Parameter \"" + name(declaration.name(i)) + "\" cannot be void");
+					else if (fallback != NO_NODE and tree[fallback].aux != type.type)
+						error(fallback, "The default of parameter \"" + name(declaration.name(i)) + "\" has to be a " + type_name(type.type));
+				}
+			}
+
+			// the type of a node whose children are checked already, and what is wrong with it
+			uint8_t type_of(NodeId id){
+				const Node& node = tree[id];
+				switch (node.type){
+					case Parser::ELEMENT_LITERAL:
+						return node.aux;
+					case Parser::ELEMENT_REF:
+						if (scope.function != NO_NODE and scope.parameters[node.a] != 0)
+							return tree.function(scope.function).type(scope.parameters[node.a] - 1).type;
+						if (macros[node.a] != NO_NODE)
+							return tree.macro_type(macros[node.a]).type;
+						error(id, "Unknown name \"" + name(node.a) + "\"");
+						return TYPE_INVALID;
+					case Parser::ELEMENT_OPERATION:
+						{
+							if (node.a != NO_NODE and node.b != NO_NODE and types[node.a] == types[node.b]){
+								const Operator* found = binary(node.aux, types[node.a]);
+								if (found != nullptr)
+									return found->type;
+							}
+							std::string op(1, (char) node.aux);
+							if (node.b == NO_NODE){
+								error(id, "Operator " + op + " is not supported yet");
+								return TYPE_INVALID;
+							}
+							if (node.a == NO_NODE){
+								uint8_t operand = types[node.b];
+								if (operand != Parser::TYPE_NUM and operand != TYPE_INVALID)
+									error(id, "Operator " + op + " does not work on a " + type_name(operand));
+								return operand == Parser::TYPE_NUM ? operand : TYPE_INVALID;
+							}
+							uint8_t left = types[node.a];
+							uint8_t right = types[node.b];
+							if (left == TYPE_INVALID or right == TYPE_INVALID)
+								return TYPE_INVALID;
+							if (binary(node.aux, Parser::TYPE_NUM) == nullptr and binary(node.aux, Parser::TYPE_STR) == nullptr)
+								error(id, "Operator " + op + " is not supported yet");
+							else
+								error(id, "Operator " + op + " does not work on " + type_name(left) + " and " + type_name(right));
+							return TYPE_INVALID;
+						}
+					case Parser::ELEMENT_FUNCTION_CALL:
+						{
+							NodeId callee = functions[node.a];
+							if (callee == NO_NODE){
+								error(id, "Unknown function \"" + name(node.a) + "\"");
+								return TYPE_INVALID;
+							}
+							Parser::Function declaration = tree.function(callee);
+							Memory::List<const NodeId> arguments = tree.list(node.b);
+							if (arguments.size() > declaration.parameter_count)
+								error(id, "Too many arguments for \"" + name(node.a) + "\", it takes " + std::to_string(declaration.parameter_count));
+							for (uint32_t i = 0; i < arguments.size() and i < declaration.parameter_count; i++){
+								uint8_t type = types[arguments[i]];
+								if (type != TYPE_INVALID and type != declaration.type(i).type)
+									error(arguments[i], "Argument " + std::to_string(i + 1) + " of \"" + name(node.a) + "\" has to be a " + type_name(declaration.type(i).type) + ", not a " + type_name(type));
+							}
+							for (uint32_t i = arguments.size(); i < declaration.parameter_count; i++)
+								if (declaration.fallback(i) == NO_NODE){
+									error(id, "Missing argument \"" + name(declaration.name(i)) + "\" for \"" + name(node.a) + "\"");
+									break;
+								}
+							return declaration.ret_type.type;
+						}
+					case Parser::ELEMENT_SERVE:
+						{
+							uint8_t type = node.a == NO_NODE ? Parser::TYPE_VOID : types[node.a];
+							if (type == TYPE_INVALID)
+								return Parser::TYPE_VOID;
+							if (scope.function == NO_NODE){
+								if (type != Parser::TYPE_NUM and node.a != NO_NODE)
+									error(id, "Only a num can be served at the top level, it is the exit code");
+								return Parser::TYPE_VOID;
+							}
+							uint8_t expected = tree.function(scope.function).ret_type.type;
+							std::string of = "Function \"" + name(tree[scope.function].a) + "\"";
+							if (expected == Parser::TYPE_VOID and type != Parser::TYPE_VOID)
+								error(id, of + " is void, it cannot serve a " + type_name(type));
+							else if (type == Parser::TYPE_VOID and expected != Parser::TYPE_VOID)
+								error(id, of + " has to serve a " + type_name(expected));
+							else if (type != expected)
+								error(id, of + " serves a " + type_name(expected) + ", not a " + type_name(type));
+							return Parser::TYPE_VOID;
+						}
+					case Parser::ELEMENT_MACRO_DEF:
+						{
+							uint8_t expected = tree.macro_type(id).type;
+							uint8_t type = types[tree.macro_body(id)];
+							if (type != TYPE_INVALID and type != expected)
+								error(id, "Macro \"" + name(node.a) + "\" is a " + type_name(expected) + ", not a " + type_name(type));
+							return Parser::TYPE_VOID;
+						}
+					case Parser::ELEMENT_FUNCTION_DEF:
+						return Parser::TYPE_VOID;
+					default:
+						error(id, "This is not supported yet");
+						return TYPE_INVALID;
+				}
+			}
+
+			const Operator* operator_of(NodeId id) const{
+				return binary(tree[id].aux, types[tree[id].a]);
+			}
+
+			int precedence(NodeId id) const{
+				const Node& node = tree[id];
+				if (node.type != Parser::ELEMENT_OPERATION)
+					return PRECEDENCE_PRIMARY;
+				if (node.a == NO_NODE)
+					return PRECEDENCE_UNARY;
+				return operator_of(id)->precedence;
+			}
+
+			// if C would read the child of the parent differently than FuSS without brackets around it
+			bool needs_brackets(NodeId parent, NodeId child) const{
+				const Node& node = tree[parent];
+				if (node.type != Parser::ELEMENT_OPERATION)
+					return false;
+				int inner = precedence(child);
+				if (node.a == NO_NODE)
+					return inner < PRECEDENCE_UNARY;
+				int outer = operator_of(parent)->precedence;
+				if (outer == PRECEDENCE_PRIMARY)
+					return false;
+				// both group operators on one level to the left, on the right an operator on the same level needs them
+				return child == node.a ? inner < outer : inner <= outer;
+			}
+
+			// the prefix is for what the symbol is, names which are not valid in C go by the id of the symbol
+			void symbol(Output::Sink& out, char prefix, Symbols::Symbol symbol) const{
+				out.put(prefix);
+				if (valid[symbol]){
+					out.put('_');
+					out.put(Symbols::table().name(symbol));
+				}
+				else
+					out.number(symbol);
+			}
+
+			void function_name(Output::Sink& out, Symbols::Symbol name) const{
+				if (has_body(functions[name]))
+					symbol(out, 'f', name);
+				else
+					out.put(Symbols::table().name(name));
+			}
+
+			void literal(Output::Sink& out, NodeId id) const{
+				const Node& node = tree[id];
+				if (node.aux == Parser::TYPE_NUM)
+					out.real(tree.number(id));
+				else if (node.aux == Parser::TYPE_STR)
+					string(out, tree.text(id));
+				else
+					out.put('0');
+			}
+
+			void type(Output::Sink& out, uint8_t type) const{
+				out.put(type == Parser::TYPE_NUM ? "num" : type == Parser::TYPE_STR ? "str" : "void");
+			}
+
+			void header(Output::Sink& out, NodeId id) const{
+				Parser::Function declaration = tree.function(id);
+				type(out, declaration.ret_type.type);
+				out.put(' ');
+				function_name(out, tree[id].a);
+				out.put('(');
+				for (uint32_t i = 0; i < declaration.parameter_count; i++){
+					if (i > 0)
+						out.put(", ");
+					type(out, declaration.type(i).type);
+					out.put(' ');
+					symbol(out, 'p', declaration.name(i));
+				}
+				if (declaration.parameter_count == 0)
+					out.put("void");
+				out.put(')');
+			}
+
+			void statement(Emitter& emitter, NodeId id) const{
+				Output::Sink& out = emitter.out;
+				Parser::Walker& walker = emitter.scope.walker;
+				const Node& node = tree[id];
+				out.put('\t');
+				if (node.type != Parser::ELEMENT_SERVE){
+					walker.walk(id, emitter);
+					out.put(";\n");
+				}
+				else if (emitter.scope.function == NO_NODE){
+					if (node.a == NO_NODE)
+						out.put("return 0;\n");
+					else{
+						out.put("return (int) (");
+						walker.walk(node.a, emitter);
+						out.put(");\n");
+					}
+				}
+				// serving null from a void function is serving nothing
+				else if (node.a == NO_NODE or types[node.a] == Parser::TYPE_VOID)
+					out.put("return;\n");
+				else{
+					out.put("return ");
+					walker.walk(node.a, emitter);
+					out.put(";\n");
+				}
+			}
+
+			// a function with a body
+			void definition(Emitter& emitter, NodeId id) const{
+				Output::Sink& out = emitter.out;
+				Parser::Function declaration = tree.function(id);
+				header(out, id);
+				out.put("{\n");
+				enter_function(emitter.scope, id);
+				for (NodeId statement : declaration.body)
+					this->statement(emitter, statement);
+				leave_function(emitter.scope);
+				// falling off the end serves nothing
+				bool served = declaration.body.size() > 0 and tree[declaration.body[declaration.body.size() - 1]].type == Parser::ELEMENT_SERVE;
+				if (declaration.ret_type.type != Parser::TYPE_VOID and not served)
+					out.put("\treturn 0;\n");
+				out.put("}\n\n");
+			}
+
+			/**
+			 * functions with a body, in order, on the thread pool when there are enough of them
+			 *
+			 * the functions are split into ranges of about Parallel::RANGE_NODES nodes, each written to a string of its own,
+			 * a wave of ranges at a time, so only a wave is in memory, and the strings go out in order, which makes the output
+			 * the same as from writing them out one after another
+			 */
+			void definitions(Emitter& emitter, Memory::List<const Definition> bodies){
+				std::vector<uint32_t> bounds{0};
+				size_t total = 0;
+				uint32_t nodes = 0;
+				for (uint32_t i = 0; i < bodies.size(); i++){
+					nodes += bodies[i].nodes;
+					total += bodies[i].nodes;
+					if (nodes >= Parallel::RANGE_NODES){
+						bounds.push_back(i + 1);
+						nodes = 0;
+					}
+				}
+				if (bounds.back() != bodies.size())
+					bounds.push_back(bodies.size());
+
+				int count = bounds.size() - 1;
+				if (total < Parallel::MIN_NODES or (this->pool != nullptr ? this->pool->size() : Threads::cores()) == 1 or count < 2){
+					for (const Definition& body : bodies)
+						definition(emitter, body.id);
+					return;
+				}
+				Threads::Pool& pool = this->pool != nullptr ? *this->pool : Threads::pool();
+
+				// the calling thread has the scope of the program
+				std::vector<std::unique_ptr<Scope>> scopes(pool.size());
+				for (int i = 1; i < pool.size(); i++)
+					scopes[i].reset(new Scope(tree, symbols));
+				int wave = pool.size() * Parallel::RANGES_PER_THREAD;
+				std::vector<std::string> parts(std::min(wave, count));
+				for (int first = 0; first < count; first += wave){
+					int ranges = std::min(wave, count - first);
+					pool.run(ranges, [&](int k){
+						int range = first + k;
+						Scope& scope = Threads::index == 0 ? this->scope : *scopes[Threads::index];
+						Output::Sink part;
+						part.collect(parts[k]);
+						Emitter emitter(*this, scope, part);
+						for (uint32_t i = bounds[range]; i < bounds[range + 1]; i++)
+							definition(emitter, bodies[i].id);
+						part.close();
+					});
+					for (int k = 0; k < ranges; k++){
+						emitter.out.put(parts[k]);
+						parts[k].clear();
+					}
+				}
+			}
+	};
+
+}
+
+namespace Process{
+
+	// the compiler, which can come with arguments of its own, like "ccache gcc", followed by more arguments
+	std::vector<std::string> command(const std::string& compiler, std::initializer_list<std::string> arguments){
+		std::vector<std::string> words;
+		for (size_t start = 0; (start = compiler.find_first_not_of(" \t", start)) != std::string::npos;){
+			size_t end = compiler.find_first_of(" \t", start);
+			words.push_back(compiler.substr(start, end - start));
+			start = end;
+		}
+		words.insert(words.end(), arguments);
+		return words;
+	}
+
+	#ifdef CFUSS_POSIX
+	/**
+	 * starts a process, without a shell in between, returns -1 if it could not
+	 *
+	 * its stdin comes from input unless that is -1, and its stdout and stderr go to the file at output unless that is null
+	 */
+	pid_t spawn(const std::vector<std::string>& arguments, int input = -1, const char* output = nullptr){
+		if (arguments.empty())
+			return -1;
+		std::vector<char*> argv;
+		for (const std::string& argument : arguments)
+			argv.push_back((char*) argument.c_str());
+		argv.push_back(nullptr);
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		if (input >= 0){
+			posix_spawn_file_actions_adddup2(&actions, input, STDIN_FILENO);
+			posix_spawn_file_actions_addclose(&actions, input);
+		}
+		if (output != nullptr){
+			posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+		}
+		pid_t pid;
+		int error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+		posix_spawn_file_actions_destroy(&actions);
+		return error == 0 ? pid : -1;
+	}
+
+	// waits for a process, returns if it exited successfully
+	bool finish(pid_t pid){
+		int status;
+		while (waitpid(pid, &status, 0) < 0)
+			if (errno != EINTR)
+				return false;
+		return WIFEXITED(status) and WEXITSTATUS(status) == 0;
+	}
+	#endif
+
+	// runs a process and waits for it, returns if it succeeded, what it prints goes to the file at output unless that is null
+	bool run(const std::vector<std::string>& arguments, const char* output = nullptr){
+		#ifdef CFUSS_POSIX
+		pid_t pid = spawn(arguments, -1, output);
+		return pid > 0 and finish(pid);
+		#else
+		std::string line;
+		for (const std::string& argument : arguments)
+			line += quote(argument) + " ";
+		if (output != nullptr)
+			line += "> " + quote(output) + " 2>&1";
+		return std::system(line.c_str()) == 0;
+		#endif
+	}
+
+	// where a program of that name is found through PATH, the name itself if it has a directory or is not found
+	std::string find(const std::string& name){
+		if (name.find_first_of("/\\") != std::string::npos)
+			return name;
+		const char* path = std::getenv("PATH");
+		if (path == nullptr)
+			return name;
+		#ifdef CFUSS_POSIX
+		const char separator = ':';
+		#else
+		const char separator = ';';
+		#endif
+		for (std::string_view rest = path; not rest.empty();){
+			size_t end = std::min(rest.find(separator), rest.size());
+			std::string candidate = std::string(rest.substr(0, end)) + "/" + name;
+			rest.remove_prefix(std::min(end + 1, rest.size()));
+			std::error_code error;
+			if (std::filesystem::is_regular_file(candidate, error))
+				return candidate;
+		}
+		return name;
+	}
+
+}
+
+namespace Objects{
+
+	namespace fs = std::filesystem;
+
+	/**
+	 * compiled translation units, in a directory shared by all builds, named by a hash of everything that goes into them:
+	 * the C code, the header it includes, the compiler, its flags and what it says its version is
+	 *
+	 * objects are touched when they are used, so once the directory is over its limit the ones unused for longest go first,
+	 * like the syntax tree cache, it is best effort, anything going wrong with it just means compiling again
+	 */
+	class Store{
+		public:
+			struct Stats{
+				size_t hits = 0;
+				size_t misses = 0;
+				size_t evicted = 0;
+				// in the directory, after trimming it
+				size_t objects = 0;
+				uint64_t bytes = 0;
+			};
+
+			Store(std::string directory, uint64_t limit) : directory(std::move(directory)), limit(limit){}
+
+			/**
+			 * takes in the compiler, with its flags, returns false if the cache cannot be used
+			 *
+			 * its version is asked for once for every build of it, told apart by the size and time of its executable,
+			 * and the answer is kept in the directory
+			 */
+			bool open(const std::string& compiler, std::string_view flags){
+				std::error_code error;
+				if (directory.empty() or (fs::create_directories(directory, error), error))
+					return false;
+				std::vector<std::string> words = Process::command(compiler, {"--version"});
+				if (words.size() < 2)
+					return false;
+				std::string executable = Process::find(words[0]);
+				std::string stamp = compiler + '\0' + executable + '\0';
+				stamp += std::to_string(fs::file_size(executable, error)) + '\0';
+				stamp += std::to_string(fs::last_write_time(executable, error).time_since_epoch().count());
+				char name[48];
+				snprintf(name, sizeof(name), "/%016llx.version", (unsigned long long) ::Cache::hash(stamp));
+				std::string path = directory + name;
+
+				Source::File known;
+				if (not known.open(path)){
+					// written next to it and moved over it, like the objects
+					std::string temporary = path + ".tmp";
+					bool asked = Process::run(words, temporary.c_str());
+					if (asked)
+						fs::rename(temporary, path, error);
+					if (not asked or error){
+						fs::remove(temporary, error);
+						return false;
+					}
+					if (not known.open(path))
+						return false;
+				}
+				identity = compiler;
+				identity += '\0';
+				identity += flags;
+				identity += '\0';
+				identity += known.code();
+				opened = true;
+				return true;
+			}
+
+			bool is_open() const{
+				return opened;
+			}
+
+			// of a unit with the header it includes
+			uint64_t key(std::string_view header, std::string_view unit) const{
+				uint64_t hashes[] = {::Cache::hash(identity), ::Cache::hash(header), ::Cache::hash(unit), unit.size()};
+				return ::Cache::hash(std::string_view((const char*) hashes, sizeof(hashes)));
+			}
+
+			// the object for the key if there is one, empty if not
+			std::string find(uint64_t key){
+				std::string path = object(key);
+				std::error_code error;
+				if (not fs::is_regular_file(path, error)){
+					stats.misses++;
+					return "";
+				}
+				fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+				stats.hits++;
+				return path;
+			}
+
+			void store(uint64_t key, const std::string& compiled){
+				std::string path = object(key);
+				// copied next to it and moved over it, so another build never sees half of it
+				std::string temporary = path + ".tmp";
+				std::error_code error;
+				if (not fs::copy_file(compiled, temporary, fs::copy_options::overwrite_existing, error))
+					return;
+				fs::rename(temporary, path, error);
+				if (error)
+					fs::remove(temporary, error);
+			}
+
+			// evicts the least recently used objects while the directory is over the limit
+			void trim(){
+				struct Entry{
+					fs::path path;
+					fs::file_time_type used;
+					uint64_t size;
+				};
+				std::vector<Entry> entries;
+				std::error_code error;
+				for (fs::directory_iterator it(directory, error), end; not error and it != end; it.increment(error)){
+					if (it->path().extension() != ".o")
+						continue;
+					std::error_code failed;
+					Entry entry = {it->path(), fs::last_write_time(it->path(), failed), fs::file_size(it->path(), failed)};
+					if (not failed)
+						entries.push_back(entry);
+				}
+				std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b){ return a.used < b.used; });
+				stats.objects = entries.size();
+				stats.bytes = 0;
+				for (const Entry& entry : entries)
+					stats.bytes += entry.size;
+				for (const Entry& entry : entries){
+					if (stats.bytes <= limit)
+						break;
+					if (fs::remove(entry.path, error)){
+						stats.bytes -= entry.size;
+						stats.objects--;
+						stats.evicted++;
+					}
+				}
+			}
+
+			const std::string& path() const{
+				return directory;
+			}
+
+			const Stats& statistics() const{
+				return stats;
+			}
+
+		private:
+			std::string directory;
+			uint64_t limit;
+			// the compiler, its flags and its version, between zeros
+			std::string identity;
+			bool opened = false;
+			Stats stats;
+
+			std::string object(uint64_t key) const{
+				char name[32];
+				snprintf(name, sizeof(name), "/%016llx.o", (unsigned long long) key);
+				return directory + name;
+			}
+	};
+
+}
+
+namespace Driver{
+
+	using Process::command;
+	using Process::run;
+	#ifdef CFUSS_POSIX
+	using Process::spawn;
+	using Process::finish;
+	#endif
+
+	// the part of a path after the last directory
+	std::string_view file_name(std::string_view path){
+		#ifdef CFUSS_POSIX
+		size_t slash = path.rfind('/');
+		#else
+		size_t slash = path.find_last_of("/\\");
+		#endif
+		return slash == std::string_view::npos ? path : path.substr(slash + 1);
+	}
+
+	// writes a file through the sink, returns false and says why if it could not
+	template<typename F>
+	bool write(Output::Sink& sink, const std::string& path, F contents){
+		if (not sink.open(path)){
+			std::cerr << "Could not open " << path << "." << std::endl;
+			return false;
+		}
+		contents(sink);
+		if (not sink.close()){
+			std::cerr << "Could not write " << path << "." << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// the flags every translation unit is compiled with, the object cache tells compilations apart by them
+	const char COMPILE_FLAGS[] = "-c";
+	// about the nodes of functions a translation unit has at least, a smaller one costs more to start a compiler for than it saves
+	const uint64_t UNIT_NODES = 1 << 14;
+
+	#ifdef CFUSS_POSIX
+	/**
+	 * compiles and links the program as a single translation unit, which goes to the compiler through a pipe as it is written,
+	 * so generating and compiling it happen at the same time, and nothing but the executable is written
+	 */
+	bool stream(Generator::Program& generator, const std::string& compiler, const std::string& output){
+		int ends[2];
+		if (pipe(ends) != 0)
+			return false;
+		// the compiler only sees the end of its input once every copy of the end written to is closed
+		fcntl(ends[1], F_SETFD, FD_CLOEXEC);
+		pid_t pid = spawn(command(compiler, {"-x", "c", "-o", output, "-", "-lm"}), ends[0]);
+		::close(ends[0]);
+		if (pid < 0){
+			::close(ends[1]);
+			return false;
+		}
+		// a compiler which gives up early closes the pipe, which should fail the write and not end the program
+		signal(SIGPIPE, SIG_IGN);
+		Output::Sink sink;
+		sink.open(ends[1]);
+		generator.emit(sink);
+		bool written = sink.close();
+		return finish(pid) and written;
+	}
+	#endif
+
+	/**
+	 * compiles a checked program to an executable at output, with its functions split between at most units translation units
+	 *
+	 * the units share a header with the prelude, the prototypes and the macros, each is compiled by a process of its own
+	 * as soon as it is written, and the objects are linked at the end, with a cache they are looked up in it before they are
+	 * compiled, and stored in it after, the files are written next to the output, and removed once they are not needed
+	 *
+	 * a single unit is compiled and linked in one go, straight from a pipe where there is posix_spawn, it is cheaper to start
+	 * than asking the compiler for its version for the cache, so the cache is only opened for more units
+	 */
+	bool build(Generator::Program& generator, const std::string& compiler, const std::string& output, int units, Objects::Store* cache){
+		using Generator::Program;
+		Output::Sink sink;
+		std::vector<Program::Definition> all = generator.bodies();
+		uint64_t nodes = 0;
+		for (const Program::Definition& definition : all)
+			nodes += definition.nodes;
+		units = std::max<uint64_t>(1, std::min<uint64_t>(units, nodes / UNIT_NODES));
+		std::vector<Memory::List<const Program::Definition>> ranges = Program::split(all, units);
+		if (ranges.size() <= 1){
+			#ifdef CFUSS_POSIX
+			return stream(generator, compiler, output);
+			#else
+			std::string source = output + ".c";
+			bool compiled =
+				    write(sink, source, [&](Output::Sink& out){ generator.emit(out); })
+				and run(command(compiler, {"-o", output, source, "-lm"}));
+			std::remove(source.c_str());
+			return compiled;
+			#endif
+		}
+		if (cache != nullptr and not cache->open(compiler, COMPILE_FLAGS))
+			cache = nullptr;
+
+		std::string header = output + ".h";
+		// the header's name comes from the output, so it is left out of the units' keys, the header's text is in them
+		std::string include = "#include \"" + std::string(file_name(header)) + "\"\n\n";
+		std::vector<std::string> sources;
+		std::vector<std::string> objects;
+		// what the objects are stored as in the cache, and if they were found there, the path in the cache
+		std::vector<uint64_t> keys;
+		std::vector<std::string> cached;
+		// the threads mostly wait for the compilers, so there is one for every unit, not just for every core
+		std::vector<std::thread> compilers;
+		std::unique_ptr<bool[]> compiled(new bool[ranges.size()]());
+		bool written = write(sink, header, [&](Output::Sink& out){ generator.declarations(out); });
+		Source::File header_file;
+		if (written and cache != nullptr)
+			written = header_file.open(header);
+		for (size_t i = 0; i < ranges.size() and written; i++){
+			sources.push_back(output + "." + std::to_string(i) + ".c");
+			objects.push_back(output + "." + std::to_string(i) + ".o");
+			written = write(sink, sources[i], [&](Output::Sink& out){
+				out.put(include);
+				// main goes with the first functions
+				generator.unit(out, ranges[i], i == 0);
+			});
+			if (written and cache != nullptr){
+				// read back, so a unit is never in memory as a whole
+				Source::File unit;
+				written = unit.open(sources[i]);
+				keys.push_back(written ? cache->key(header_file.code(), unit.code().substr(include.size())) : 0);
+				cached.push_back(written ? cache->find(keys[i]) : "");
+				if (not cached[i].empty()){
+					objects[i] = cached[i];
+					compiled[i] = true;
+					continue;
+				}
+			}
+			// the command is put together here, sources and objects grow while the compilers run
+			if (written)
+				compilers.emplace_back([&compiled, i, arguments = command(compiler, {COMPILE_FLAGS, "-o", objects[i], sources[i]})]{
+					compiled[i] = run(arguments);
+				});
+		}
+		for (std::thread& thread : compilers)
+			thread.join();
+
+		bool linked = written and std::all_of(compiled.get(), compiled.get() + ranges.size(), [](bool done){ return done; });
+		if (linked){
+			std::vector<std::string> link = command(compiler, {"-o", output});
+			link.insert(link.end(), objects.begin(), objects.end());
+			link.push_back("-lm");
+			linked = run(link);
+		}
+		std::remove(header.c_str());
+		for (size_t i = 0; i < sources.size(); i++){
+			std::remove(sources[i].c_str());
+			if (cache == nullptr or i >= cached.size() or cached[i].empty()){
+				if (cache != nullptr and i < keys.size() and compiled[i])
+					cache->store(keys[i], objects[i]);
+				std::remove(objects[i].c_str());
+			}
+		}
+		if (cache != nullptr)
+			cache->trim();
+		return linked;
+	}
+
+}
+
+// tests include the whole compiler, and bring a main of their own
+#ifndef CFUSS_NO_MAIN
+int main(int argc, char *argv[]){
+	argparse::ArgumentParser program("CFuSS");
+
+	program.add_argument("input")
+		.required()
+		.help("input file, - to read from stdin");
+
+	program.add_argument("--output", "-o")
+		.default_value(std::string("output"))
+		.help("output file");
+
+	program.add_argument("--c-compiler", "-c")
+		.default_value(std::string("gcc"))
+		.help("c compiler to use");
+
+	program.add_argument("--jobs", "-j")
+		.default_value(0)
+		.scan<'i', int>()
+		.help("Split the C code into this many translation units, compiled at the same time, 0 for one per core.");
+
+	program.add_argument("--stop-at-c", "-s")
+		.default_value(false)
+		.implicit_value(true)
+		.help("Don't compile the C code, and output it.");
+
+	program.add_argument("--tokens")
+		.default_value(false)
+		.implicit_value(true)
+		.help("Print the tokens.");
+
+	program.add_argument("--ast")
+		.default_value(false)
+		.implicit_value(true)
+		.help("Print the AST.");
+
+	program.add_argument("--trace-lexer")
+		.default_value(false)
+		.implicit_value(true)
+		.help("Record the lexer's debug flags for every token, shown with --tokens.");
+
+	program.add_argument("--trace-parser")
+		.default_value(false)
+		.implicit_value(true)
+		.help("Print what the parser did along the way.");
+
+	program.add_argument("--max-errors")
+		.default_value(20)
+		.scan<'i', int>()
+		.help("Stop parsing after this many errors, 0 for no limit.");
+
+	program.add_argument("--ast-cache")
+		.default_value(Cache::directory().empty() ? std::string() : Cache::directory() + "/trees")
+		.help("Directory the syntax trees of inputs are cached in.");
+
+	program.add_argument("--no-ast-cache")
+		.default_value(false)
+		.implicit_value(true)
+		.help("Don't read or write the syntax tree cache.");
+
+	program.add_argument("--object-cache")
+		.default_value(Cache::directory())
+		.help("Directory compiled C code is cached in.");
+
+	program.add_argument("--no-object-cache")
+		.default_value(false)
+		.implicit_value(true)
+		.help("Don't look up or store compiled C code in the object cache.");
+
+	program.add_argument("--cache-size")
+		.default_value(1024)
+		.scan<'i', int>()
+		.help("Megabytes the object cache is kept under, the least recently used objects go first.");
+
+	program.add_argument("--cache-stats")
+		.default_value(false)
+		.implicit_value(true)
+		.help("Print how the object cache did.");
+
+	program.add_argument("--alloc-stats")
+		.default_value(false)
+		.implicit_value(true)
+		.help("Print how many heap allocations reading, lexing and parsing the input took.");
+
+	try{
+		program.parse_args(argc, argv);
+	}
+	catch(const std::runtime_error& e){
+		std::cerr << e.what() << std::endl;
+		std::cerr << program;
+		return 1;
+	}
+
+	// argument parsing is not counted
+	if (program.get<bool>("--alloc-stats"))
+		Memory::counting = true;
+
+	// try to open the input file
+	std::string input_path = program.get<std::string>("input");
+	Source::File input;
+	if(!input.open(input_path)){
+		std::cerr << "Could not open input file. Terminating." << std::endl;
+		return 1;
+	}
+	std::string_view code = input.code();
+	if (code.size() > Lexer::MAX_SIZE){
+		std::cerr << "The input file is " << code.size() << " bytes long, inputs of more than " << Lexer::MAX_SIZE << " bytes are not supported. Terminating." << std::endl;
+		return 1;
+	}
+
+	// an unchanged file skips lexing and parsing, unless their details are asked for
+	bool use_cache =
+		    not program.get<bool>("--no-ast-cache")
+		and not program.get<std::string>("--ast-cache").empty()
+		and input_path != "-"
+		and not program.get<bool>("--tokens")
+		and not program.get<bool>("--trace-lexer")
+		and not program.get<bool>("--trace-parser");
+	std::string cache_path = Cache::path(program.get<std::string>("--ast-cache"), input_path);
+	int max_errors = std::max(program.get<int>("--max-errors"), 0);
+	Lexer::TokenBuffer tokens;
+	Parser::ParseResult res;
+	if (use_cache and Cache::load(cache_path, code, res.tree)){
+		res.successful = true;
+		printf("loaded the syntax tree from %s\n", cache_path.c_str());
+	}
+	else{
+		// tokenize the input file, the tokens point into it until the end
+		tokens = Lexer::tokenize(code, program.get<bool>("--trace-lexer"));
+
+		printf("tokenized successfully\n");
+
+		if (program.get<bool>("--tokens")){
+			// print the tokens
+			printf("\n");
+
+			int max_value_length = 0;
+			for (int i = 0; i < tokens.size(); i++)
+				max_value_length = std::max<int>(max_value_length, escaped_length(tokens.value(i)));
+
+			std::string value;
+			for (int i = 0; i < tokens.size(); i++){
+				value.clear();
+				escape(tokens.value(i), value);
+				printf(
+					"[%2d] %2d: \"%s\"%*s%d %-4s\n",
+					i,
+					tokens.type(i), value.c_str(),
+					max_value_length - value.length() + 6,
+					" line ", tokens.line(i), tokens.debug.empty() ? "" : Lexer::debug_string(tokens.debug[i]).c_str()
+				);
+			}
+		}
+
+		// parse the tokens
+		res = Parser::_parse(tokens, program.get<bool>("--trace-parser"), max_errors);
+		if (use_cache and res.successful)
+			Cache::store(cache_path, code, res.tree);
+	}
+	const Parser::Tree& tree = res.tree;
+
+	if (program.get<bool>("--alloc-stats")){
+		Memory::counting = false;
+		size_t count = Memory::allocations;
+		size_t bytes = Memory::allocated_bytes;
+		double kb = std::max<size_t>(code.size(), 1) / 1024.0;
+		printf("allocations: %zu (%.3f per KB of input), %zu bytes\n", count, count / kb, bytes);
+	}
+
+	for (const Parser::TraceEntry& entry : Parser::trace_log)
+		printf("trace %d | %s\n", entry.line, entry.message.c_str());
+
+	// the lines are only needed to show errors, a tree from the cache comes without them
+	Lexer::LineIndex& lines = tokens.lines;
+	auto show_errors = [&](const Parser::Diagnostics& errors){
+		if (lines.starts.empty())
+			lines.build(code);
+		for (const Parser::ParserError& error : errors.list()){
+			printf("%.*s:\n", (int) error.message.size(), error.message.data());
+			// point at the column when the error is about a span of the source
+			const char* at = error.at.data();
+			if (at != nullptr and at >= code.data() and at < code.data() + code.size()){
+				Lexer::LineIndex::Position pos = lines.locate(at - code.data());
+				std::string_view text = lines.text(pos.line);
+				std::string prefix = std::to_string(pos.line) + ":" + std::to_string(pos.column);
+				printf("%s | %.*s\n", prefix.c_str(), (int) text.size(), text.data());
+				// columns count bytes, so the tabs before the column are kept and every other character becomes a space
+				std::string caret;
+				for (char c : text.substr(0, std::min<size_t>(pos.column - 1, text.size())))
+					if (c == '\t')
+						caret += '\t';
+					else if (((unsigned char) c & 0xC0) != 0x80)  // not the middle of a utf-8 character
+						caret += ' ';
+				printf("%*s | %s^\n", (int) prefix.size(), "", caret.c_str());
+			}
+			else{
+				std::string_view text = lines.text(error.line);
+				printf("%d | %.*s\n", error.line, (int) text.size(), text.data());
+			}
+		}
+		if (errors.full())
+			printf("Too many errors, stopped after %d.\n", max_errors);
+	};
+
+	if (!res.successful){
+		show_errors(res.errors);
+		std::cerr << "Parsing failed. Terminating." << std::endl;
+		return 1;
+	}
+
+	else{
+		printf("parsed successfully\n");
+	}
+	printf("got %d elements\n", tree.statements().size());
+
+	// print the elements
+	printf("\n");
+
+	int max_value_length = 0;
+	for (Parser::NodeId id : tree.statements())
+		max_value_length = std::max<int>(max_value_length, escaped_length(tree.value(id)));
+
+	std::string value;
+	for (Parser::NodeId id : tree.statements()){
+		value.clear();
+		escape(tree.value(id), value);
+		printf(
+			"%2d: \"%s\"%*s%d\n",
+			tree[id].type, value.c_str(),
+			max_value_length - value.length() + 6,
+			" line ", tree[id].line
+		);
+	}
+
+	if (program.get<bool>("--ast")){
+		// the whole tree, statement by statement
+		printf("\n");
+		Parser::Walker walker(tree);
+		Parser::Printer printer(tree, stdout);
+		for (Parser::NodeId id : tree.statements())
+			walker.walk(id, printer);
+	}
+
+	Generator::Program generator(tree, max_errors);
+	if (not generator.check()){
+		show_errors(generator.errors());
+		std::cerr << "Generating C failed. Terminating." << std::endl;
+		return 1;
+	}
+
+	std::string output = program.get<std::string>("--output");
+	if (program.get<bool>("--stop-at-c")){
+		Output::Sink sink;
+		if (not Driver::write(sink, output, [&](Output::Sink& out){ generator.emit(out); })){
+			std::cerr << "Generating C failed. Terminating." << std::endl;
+			return 1;
+		}
+		printf("generated %s\n", output.c_str());
+		return 0;
+	}
+
+	int jobs = program.get<int>("--jobs");
+	if (jobs <= 0)
+		jobs = Threads::cores();
+	std::string compiler = program.get<std::string>("--c-compiler");
+	Objects::Store store(program.get<std::string>("--object-cache"), (uint64_t) std::max(program.get<int>("--cache-size"), 0) << 20);
+	// only opened for programs split into several translation units
+	Objects::Store* cache = program.get<bool>("--no-object-cache") ? nullptr : &store;
+	bool built = Driver::build(generator, compiler, output, jobs, cache);
+
+	if (program.get<bool>("--cache-stats")){
+		if (not store.is_open())
+			printf("object cache: not used\n");
+		else{
+			const Objects::Store::Stats& stats = store.statistics();
+			printf(
+				"object cache %s: %zu hits, %zu misses, %zu evicted, %zu objects, %.1f MiB\n",
+				store.path().c_str(), stats.hits, stats.misses, stats.evicted, stats.objects, stats.bytes / 1048576.0
+			);
+		}
+	}
+	if (not built){
+		std::cerr << "Compiling the C code failed. Terminating." << std::endl;
+		return 1;
 	}
+	printf("compiled %s\n", output.c_str());
 }
+#endif
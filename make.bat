@@ -1,3 +1,3 @@
 @echo off
 
-c++ compiler.c++ -std=c++17 -o compiler.exe
+c++ compiler.c++ -std=c++17 -pthread -o compiler.exe
@@ -0,0 +1,66 @@
+// a program split into several translation units has every one compiled, and all of the objects linked, built with
+// -fsanitize=thread, since the units are compiled on threads of their own while the next ones are written
+#include "common.h"
+
+// functions of about 200 nodes each, enough for several units
+std::string source(int functions){
+	std::string code;
+	for (int i = 0; i < functions; i++){
+		code += "static func num f" + std::to_string(i) + "(num a, num b)[\n\tserve a";
+		for (int j = 0; j < 50; j++)
+			code += " + (a * " + std::to_string(j) + " - b)";
+		code += "\n]\n";
+	}
+	code += "serve f0(1, 2) - 40\n";
+	return code;
+}
+
+int main(){
+	const int UNITS = 4;
+	Checked program(source(UNITS * Driver::UNIT_NODES / 200 + 100));
+	check(program.ok, "the program has errors");
+
+	std::string directory = temporary_directory();
+	std::string compiler = fake_compiler(directory);
+	std::string output = directory + "/program";
+	check(Driver::build(*program.generator, compiler, output, UNITS, nullptr), "the build failed");
+
+	int compiled = 0;
+	int linked = 0;
+	for (const std::string& line : lines(directory + "/log")){
+		check(line.rfind("missing", 0) != 0, line);
+		if (line.rfind("-c ", 0) == 0)
+			compiled++;
+		else if (line.rfind("-o " + output + " ", 0) == 0){
+			linked++;
+			int objects = 0;
+			for (size_t at = 0; (at = line.find(".o", at)) != std::string::npos; at++)
+				objects++;
+			check(objects == UNITS, "the link has " + std::to_string(objects) + " objects");
+		}
+	}
+	check(compiled == UNITS, std::to_string(compiled) + " units compiled");
+	check(linked == 1, std::to_string(linked) + " links");
+	// only the executable is left, next to the compiler and its log
+	int left = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+		left++;
+	check(left == 3, std::to_string(left) + " files left");
+
+	// built again under another name, the units are the same, so they all come from the cache
+	Objects::Store cache(directory + "/objects", 1 << 30);
+	auto compiles = [&]{
+		int count = 0;
+		for (const std::string& line : lines(directory + "/log"))
+			count += line.rfind("-c ", 0) == 0;
+		return count;
+	};
+	check(Driver::build(*program.generator, compiler, output, UNITS, &cache), "the cached build failed");
+	int before = compiles();
+	check(Driver::build(*program.generator, compiler, directory + "/other", UNITS, &cache), "the build under another name failed");
+	check(compiles() == before, std::to_string(compiles() - before) + " units compiled again under another name");
+	check(cache.statistics().hits == UNITS, std::to_string(cache.statistics().hits) + " units found in the cache");
+
+	std::filesystem::remove_all(directory);
+	return finish("build");
+}
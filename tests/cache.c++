@@ -0,0 +1,96 @@
+// a stored syntax tree loads back as the same tree, and a cache file which does not fit the source, or is broken, is not used
+#include "common.h"
+
+std::string source(int functions){
+	std::string code;
+	for (int i = 0; i < functions; i++)
+		code += "static func num f" + std::to_string(i) + "(num a, num b 2)[\n\tserve a + b * " + std::to_string(i) + " - 1.5\n]\n"
+			+ "static macro str m" + std::to_string(i) + " \"text " + std::to_string(i) + "\"\n"
+			+ "f" + std::to_string(i) + "(" + std::to_string(i) + ", ~ x) + \"s\"\n";
+	return code;
+}
+
+std::string read(const std::string& path){
+	std::ifstream file(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+void write(const std::string& path, const std::string& data){
+	std::ofstream(path, std::ios::binary) << data;
+}
+
+int main(){
+	std::string directory = temporary_directory();
+	std::string code = source(300);
+	Lexer::TokenBuffer tokens = Lexer::tokenize(code, false);
+	Parser::ParseResult parsed = Parser::_parse(tokens, false, 20);
+	check(parsed.successful, "the source has errors");
+
+	// the file is named by the source, and its directory is made when it is missing
+	std::string path = Cache::path(directory + "/trees", "module.fuss");
+	check(path == Cache::path(directory + "/trees", "./module.fuss"), "the same source gets another file");
+	check(path != Cache::path(directory + "/trees", "other.fuss"), "another source gets the same file");
+	Cache::store(path, code, parsed.tree);
+
+	Parser::Tree loaded;
+	check(Cache::load(path, code, loaded), "the stored tree does not load");
+	Compare::trees("round trip", parsed.tree, loaded);
+
+	// the same tree is written the same way
+	std::string stored = read(path);
+	Cache::store(path, code, loaded);
+	check(read(path) == stored, "storing the loaded tree again gives another file");
+
+	std::string changed = code;
+	changed[changed.size() / 2] = 'q';
+	check(not Cache::load(path, changed, loaded), "a tree loads for a changed source");
+	check(not Cache::load(path, code.substr(1), loaded), "a tree loads for a shorter source");
+
+	// an operation or serve pointing at itself, which the parser never makes
+	Cache::Header header;
+	std::memcpy(&header, stored.data(), sizeof(header));
+	auto point_at_itself = [&](std::string& data, Parser::NodeId id){
+		Parser::Node node;
+		size_t at = sizeof(Cache::Header) + id * sizeof(Parser::Node);
+		std::memcpy(&node, data.data() + at, sizeof(node));
+		if (node.type != Parser::ELEMENT_OPERATION and node.type != Parser::ELEMENT_SERVE)
+			return false;
+		node.a = id;
+		std::memcpy(&data[at], &node, sizeof(node));
+		return true;
+	};
+	Parser::NodeId first = 0;
+	for (Parser::NodeId id = 1; id < header.nodes; id++){
+		std::string broken = stored;
+		if (not point_at_itself(broken, id))
+			continue;
+		if (first == 0)
+			first = id;
+		write(path, broken);
+		check(not Cache::load(path, code, loaded), "node " + std::to_string(id) + " may point at itself");
+		check(loaded.nodes.empty(), "a rejected tree is kept");
+	}
+
+	// a new name in a file which is broken otherwise is not interned
+	{
+		std::string broken = stored;
+		point_at_itself(broken, first);
+		const std::string name = "name_nobody_uses";
+		uint32_t length = name.size();
+		size_t lengths_end = sizeof(Cache::Header) + header.nodes * sizeof(Parser::Node) + (header.extra + header.symbols) * sizeof(uint32_t);
+		broken.insert(lengths_end, (const char*) &length, sizeof(length));
+		broken += name;
+		header.symbols++;
+		header.names += length;
+		std::memcpy(&broken[0], &header, sizeof(header));
+		size_t size_before = Symbols::table().size();
+		write(path, broken);
+		check(not Cache::load(path, code, loaded), "a broken file with a new name loads");
+		check(Symbols::table().find(name) == Symbols::NONE, "the name of a broken file is interned");
+		check(Symbols::table().size() == size_before, "the names of a broken file are interned");
+	}
+
+	check(not Cache::load(directory + "/missing.fussc", code, loaded), "a missing file loads");
+	std::filesystem::remove_all(directory);
+	return finish("cache");
+}
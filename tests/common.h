@@ -0,0 +1,171 @@
+// what the tests share: counting failures, and comparing syntax trees and errors
+#pragma once
+
+#define CFUSS_NO_MAIN
+#include "../compiler.c++"
+
+int failures = 0;
+
+void check(bool ok, const std::string& what){
+	if (not ok){
+		printf("FAIL %s\n", what.c_str());
+		failures++;
+	}
+}
+
+// the result of a test program, and its exit code
+int finish(const char* name){
+	if (failures == 0)
+		printf("%s: ok\n", name);
+	return failures != 0;
+}
+
+namespace Compare{
+
+	bool same(const Parser::Node& a, const Parser::Node& b){
+		return a.type == b.type and a.aux == b.aux and a.flags == b.flags and a.line == b.line
+			and a.offset == b.offset and a.length == b.length and a.a == b.a and a.b == b.b;
+	}
+
+	// the same nodes with the same ids, node by node
+	void trees(const std::string& name, const Parser::Tree& a, const Parser::Tree& b){
+		check(a.nodes.size() == b.nodes.size(), name + ": " + std::to_string(a.nodes.size()) + " nodes against " + std::to_string(b.nodes.size()));
+		for (size_t i = 0; i < std::min(a.nodes.size(), b.nodes.size()); i++)
+			if (not same(a.nodes[i], b.nodes[i])){
+				check(false, name + ": node " + std::to_string(i) + " differs");
+				break;
+			}
+		check(a.extra == b.extra, name + ": extra differs");
+		check(a.strings == b.strings, name + ": strings differ");
+		check(a.top == b.top, name + ": top differs");
+	}
+
+	// trees numbered differently are compared by what the nodes say, and their children, following the layout of Parser::Node
+	bool same(const Parser::Tree& ta, Parser::NodeId a, const Parser::Tree& tb, Parser::NodeId b){
+		using namespace Parser;
+		if (a == NO_NODE or b == NO_NODE)
+			return a == b;
+		const Node& x = ta[a];
+		const Node& y = tb[b];
+		if (x.type != y.type or x.aux != y.aux or x.line != y.line or x.offset != y.offset or x.length != y.length)
+			return false;
+		auto lists = [&](Memory::List<const uint32_t> p, Memory::List<const uint32_t> q){
+			if (p.size() != q.size())
+				return false;
+			for (size_t i = 0; i < p.size(); i++)
+				if (not same(ta, p[i], tb, q[i]))
+					return false;
+			return true;
+		};
+		switch (x.type){
+			case ELEMENT_LITERAL:
+				if (x.aux == TYPE_STR)
+					return ta.text(a) == tb.text(b);
+				return x.a == y.a and x.b == y.b;
+			case ELEMENT_REF:
+				return x.a == y.a;
+			case ELEMENT_OPERATION:
+				return same(ta, x.a, tb, y.a) and same(ta, x.b, tb, y.b);
+			case ELEMENT_SERVE:
+				return same(ta, x.a, tb, y.a);
+			case ELEMENT_FUNCTION_CALL:
+				return x.a == y.a and lists(ta.list(x.b), tb.list(y.b));
+			case ELEMENT_MACRO_DEF:
+				return x.a == y.a and ta.macro_type(a).packed() == tb.macro_type(b).packed()
+					and same(ta, ta.macro_body(a), tb, tb.macro_body(b));
+			case ELEMENT_FUNCTION_DEF:
+				{
+					Function f = ta.function(a);
+					Function g = tb.function(b);
+					if (x.a != y.a or f.ret_type.packed() != g.ret_type.packed() or f.parameter_count != g.parameter_count)
+						return false;
+					for (uint32_t i = 0; i < f.parameter_count; i++)
+						if (f.name(i) != g.name(i) or f.type(i).packed() != g.type(i).packed() or not same(ta, f.fallback(i), tb, g.fallback(i)))
+							return false;
+					return lists(f.body, g.body);
+				}
+			default:
+				return x.a == y.a and x.b == y.b;
+		}
+	}
+
+	// the same top level statements, however the nodes are numbered
+	void statements(const std::string& name, const Parser::Tree& a, const Parser::Tree& b){
+		Memory::List<const Parser::NodeId> x = a.statements();
+		Memory::List<const Parser::NodeId> y = b.statements();
+		check(x.size() == y.size(), name + ": " + std::to_string(x.size()) + " statements against " + std::to_string(y.size()));
+		for (size_t i = 0; i < std::min(x.size(), y.size()); i++)
+			if (not same(a, x[i], b, y[i])){
+				check(false, name + ": statement " + std::to_string(i) + " differs");
+				break;
+			}
+	}
+
+	// the same errors, pointing at the same offsets of their sources, and the same outcome
+	void results(const std::string& name, const Parser::ParseResult& a, std::string_view a_code, const Parser::ParseResult& b, std::string_view b_code){
+		Memory::List<const Parser::ParserError> x = a.errors.list();
+		Memory::List<const Parser::ParserError> y = b.errors.list();
+		check(x.size() == y.size(), name + ": " + std::to_string(x.size()) + " errors against " + std::to_string(y.size()));
+		for (size_t i = 0; i < std::min(x.size(), y.size()); i++)
+			check(
+				    x[i].line == y[i].line and x[i].message == y[i].message
+				and x[i].at.data() - a_code.data() == y[i].at.data() - b_code.data() and x[i].at.size() == y[i].at.size(),
+				name + ": error " + std::to_string(i) + " differs"
+			);
+		check(a.successful == b.successful, name + ": success differs");
+	}
+
+}
+
+// a source lexed, parsed and checked, the way main does it
+struct Checked{
+	std::string code;
+	Lexer::TokenBuffer tokens;
+	Parser::ParseResult parsed;
+	std::unique_ptr<Generator::Program> generator;
+	bool ok;
+
+	explicit Checked(std::string source) : code(std::move(source)){
+		tokens = Lexer::tokenize(code, false);
+		parsed = Parser::_parse(tokens, false, 20);
+		generator.reset(new Generator::Program(parsed.tree, 20));
+		ok = parsed.successful and generator->check();
+	}
+
+	Checked(const Checked&) = delete;
+	Checked& operator=(const Checked&) = delete;
+};
+
+// a new empty directory, which the test removes when it is done with it
+std::string temporary_directory(){
+	std::string path = (std::filesystem::temp_directory_path() / "cfuss-test-XXXXXX").string();
+	if (mkdtemp(&path[0]) == nullptr){
+		perror("mkdtemp");
+		exit(1);
+	}
+	return path;
+}
+
+// a script standing in for a C compiler, it logs its arguments and creates the file after -o
+std::string fake_compiler(const std::string& directory){
+	std::string path = directory + "/cc";
+	std::ofstream script(path);
+	script
+		<< "#!/bin/sh\n"
+		<< "echo \"$@\" >> " << directory << "/log\n"
+		<< "for last; do :; done\n"
+		<< "case \"$last\" in *.c) test -f \"$last\" || echo \"missing $last\" >> " << directory << "/log;; esac\n"
+		<< "while [ $# -gt 0 ]; do if [ \"$1\" = -o ]; then : > \"$2\"; fi; shift; done\n";
+	script.close();
+	std::filesystem::permissions(path, std::filesystem::perms::owner_all);
+	return path;
+}
+
+// the lines of a file
+std::vector<std::string> lines(const std::string& path){
+	std::vector<std::string> result;
+	std::ifstream file(path);
+	for (std::string line; std::getline(file, line);)
+		result.push_back(line);
+	return result;
+}
@@ -0,0 +1,54 @@
+// functions written out on several threads come out in source order, byte for byte like written out on one
+#include "common.h"
+
+// functions of about 200 nodes each, with different names, parameters and strings, so any two of them tell apart
+std::string source(int functions){
+	std::string code;
+	for (int i = 0; i < functions; i++){
+		code += "static func num f" + std::to_string(i) + "(num a, str s, num p" + std::to_string(i) + " " + std::to_string(i) + ")[\n\tserve a";
+		for (int j = 0; j < 30; j++)
+			code += " + (p" + std::to_string(i) + " * " + std::to_string(j) + " - a)";
+		code += " + same(s, \"" + std::to_string(i) + "\")\n]\n";
+	}
+	code += "static func num same(str a, str b)[\n\tserve a = b\n]\n";
+	code += "serve f" + std::to_string(functions - 1) + "(1, \"x\")\n";
+	return code;
+}
+
+std::string emit(const Parser::Tree& tree, Threads::Pool& pool){
+	Generator::Program program(tree, 20, &pool);
+	check(program.check(), "the program has errors");
+	std::string c;
+	Output::Sink sink;
+	sink.collect(c);
+	program.emit(sink);
+	sink.close();
+	return c;
+}
+
+int main(){
+	const int FUNCTIONS = 2000;
+	std::string code = source(FUNCTIONS);
+	Lexer::TokenBuffer tokens = Lexer::tokenize(code, false);
+	Parser::ParseResult parsed = Parser::_parse(tokens, false, 20);
+	check(parsed.successful, "the source has errors");
+	check(parsed.tree.nodes.size() > 2 * Generator::Parallel::MIN_NODES, "the source is too small to be written out in parallel");
+
+	Threads::Pool one(1);
+	Threads::Pool four(4);
+	std::string serial = emit(parsed.tree, one);
+	std::string parallel = emit(parsed.tree, four);
+	check(serial == parallel, "the C written out on four threads differs");
+
+	// and the order is the one of the source
+	size_t last = 0;
+	for (int i = 0; i < FUNCTIONS; i++){
+		size_t at = parallel.find("num f_f" + std::to_string(i) + "(num p_a, str p_s, num p_p" + std::to_string(i) + "){");
+		if (at == std::string::npos or at < last){
+			check(false, "f" + std::to_string(i) + " is missing or out of order");
+			break;
+		}
+		last = at;
+	}
+	return finish("emit");
+}
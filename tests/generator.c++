@@ -0,0 +1,89 @@
+// the C written for a program compiles, and the program does what its FuSS says, the repository's example is turned away
+#include "common.h"
+
+struct Run{
+	int status;
+	std::string output;
+};
+
+// writes the C of the program, compiles it with $CC or cc, and runs it
+Run run(const std::string& directory, const std::string& name, const std::string& code){
+	Checked program(code);
+	check(program.ok, name + ": the program has errors");
+	if (not program.ok)
+		return {-1, ""};
+	std::string source = directory + "/" + name + ".c";
+	std::string executable = directory + "/" + name;
+	Output::Sink sink;
+	check(Driver::write(sink, source, [&](Output::Sink& out){ program.generator->emit(out); }), name + ": the C was not written");
+	const char* compiler = std::getenv("CC");
+	std::string log = directory + "/" + name + ".log";
+	if (not Process::run(Process::command(compiler != nullptr ? compiler : "cc", {"-w", "-o", executable, source, "-lm"}), log.c_str())){
+		check(false, name + ": the C does not compile");
+		return {-1, ""};
+	}
+	std::string output = directory + "/" + name + ".out";
+	int status = std::system((executable + " > " + output).c_str());
+	std::ifstream file(output, std::ios::binary);
+	return {WIFEXITED(status) ? WEXITSTATUS(status) : -1, std::string(std::istreambuf_iterator<char>(file), {})};
+}
+
+void expect(const std::string& directory, const std::string& name, const std::string& code, int status, const std::string& output){
+	Run result = run(directory, name, code);
+	check(result.status == status, name + ": exits with " + std::to_string(result.status) + ", not " + std::to_string(status));
+	check(result.output == output, name + ": prints \"" + result.output + "\", not \"" + output + "\"");
+}
+
+int main(){
+	std::string directory = temporary_directory();
+
+	// default values, macros, calls before declarations, and an external C function
+	expect(directory, "calls",
+		"static func void puts(str s)\n"
+		"puts(greet())\n"
+		"puts(greet(\"there\"))\n"
+		"static func num twice(num x)[\n\tserve x * 2\n]\n"
+		"static func str greet(str name \"world\")[\n\tserve \"hello \" + name\n]\n"
+		"static macro num base 7\n"
+		"serve twice(base) - 4 : 2\n",
+		5, "hello world\nhello there\n"
+	);
+	// every binary operator has the same precedence and groups to the left
+	expect(directory, "operators",
+		"static func num same(str a, str b)[\n\tserve a = b\n]\n"
+		"serve same(\"x\", \"x\") + same(\"x\", \"y\") * 10 + 7 % 4 + (1 < 2) + (3 > 4)\n",
+		2, ""
+	);
+	expect(directory, "fractions",
+		"static func num half(num x)[\n\tserve x : 2\n]\n"
+		"static macro num k 1.75\n"
+		"static func num g(num x 0.25)[\n\tserve x * 0.5\n]\n"
+		"serve half(3) + k + g() + 10.5 : 0.5\n",
+		27, ""
+	);
+	// text goes into C string literals as it is, tabs, backslashes and trigraph-like marks included
+	expect(directory, "strings",
+		"static func void puts(str s)\n"
+		"puts(\"tab\there and ?? marks \\\\ back\")\n",
+		0, "tab\there and ?? marks \\\\ back\n"
+	);
+	// names which mean something in C are prefixed
+	expect(directory, "names",
+		"static func num int(num return)[\n\tserve return + 1\n]\n"
+		"static macro num main 40\n"
+		"serve int(main)\n",
+		41, ""
+	);
+
+	std::ifstream file("test.fuss", std::ios::binary);
+	Checked example(std::string(std::istreambuf_iterator<char>(file), {}));
+	check(not example.code.empty(), "test.fuss: not found, run the tests from the repository");
+	// it parses, but adds numbers to strings
+	bool mixed = false;
+	for (const Parser::ParserError& error : example.generator->errors().list())
+		mixed |= error.message.find("does not work on num and str") != std::string_view::npos;
+	check(example.parsed.successful and not example.ok and mixed, "test.fuss: the numbers added to strings are not found");
+
+	std::filesystem::remove_all(directory);
+	return finish("generator");
+}
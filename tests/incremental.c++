@@ -0,0 +1,68 @@
+// after every edit of a document, its tokens, tree and errors have to be the same as from lexing and parsing it again
+#include "common.h"
+
+#include <random>
+
+void compare(const std::string& name, const Incremental::Document& document, uint32_t max_errors){
+	std::string_view code = document.code();
+	Lexer::TokenBuffer tokens = Lexer::tokenize(code, false);
+	Parser::ParseResult fresh = Parser::Reader<false>(tokens, max_errors, 0, tokens.size()).parse();
+	const Lexer::TokenBuffer& kept = document.tokens();
+
+	check(kept.types == tokens.types and kept.offsets == tokens.offsets and kept.lengths == tokens.lengths, name + ": tokens differ");
+	check(kept.symbols == tokens.symbols, name + ": symbols differ");
+	check(kept.partners == tokens.partners, name + ": partners differ");
+	check(kept.lines.starts == tokens.lines.starts, name + ": line starts differ");
+
+	Compare::statements(name, document.parsed().tree, fresh.tree);
+	Compare::results(name, document.parsed(), code, fresh, code);
+}
+
+int main(){
+	// pieces of statements, and now and then broken ones, which open and close strings, brackets and bodies
+	const char* pieces[] = {
+		"x", "1", " + ", "2.5", "\n", "f(2, a)", "\"ab\"", ", ",
+		"static func num g(num a, num b 3)[\n\tserve a + b\n]\n", "static macro num m 4\n", "serve 3\n",
+	};
+	const char* broken[] = {"\"", "[", "]", "(", ")", "1 + * 2\n", "~"};
+	std::string code;
+	for (int i = 0; i < 200; i++)
+		code += i % 10 == 0 ? "static func num f" + std::to_string(i) + "(num a)[\n\tserve a * " + std::to_string(i) + "\n]\n"
+			: "f" + std::to_string(i / 10 * 10) + "(" + std::to_string(i) + ") + \"s\"\n";
+
+	for (uint32_t max_errors : {0u, 20u}){
+		std::mt19937 random(max_errors + 1);
+		Incremental::Document document(code, max_errors);
+		int incremental = 0;
+		const int EDITS = 2000;
+		for (int i = 0; i < EDITS and failures == 0; i++){
+			uint32_t size = document.code().size();
+			uint32_t offset = random() % (size + 1);
+			uint32_t length = std::min<uint32_t>(random() % 8, size - offset);
+			std::string text;
+			for (int j = random() % 3; j > 0; j--)
+				text += random() % 10 == 0 ? broken[random() % (sizeof(broken) / sizeof(broken[0]))] : pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))];
+			incremental += document.edit({offset, length, text});
+			compare("limit " + std::to_string(max_errors) + ", edit " + std::to_string(i), document, max_errors);
+		}
+		printf("limit %u: %d of %d edits incremental\n", max_errors, incremental, EDITS);
+
+		// edits past the end are cut short there
+		std::string name = "limit " + std::to_string(max_errors) + ", ";
+		std::string expected(document.code());
+		uint32_t size = expected.size();
+		document.edit({size - 3, 100, "x\n"});
+		expected.replace(size - 3, 3, "x\n");
+		check(document.code() == expected, name + "an edit running past the end is not cut short");
+		compare(name + "edit running past the end", document, max_errors);
+		document.edit({(uint32_t) expected.size() + 50, 10, "serve 3\n"});
+		expected += "serve 3\n";
+		check(document.code() == expected, name + "an edit starting past the end does not append");
+		compare(name + "edit starting past the end", document, max_errors);
+		document.edit({UINT32_MAX - 1, UINT32_MAX, "1\n"});
+		expected += "1\n";
+		check(document.code() == expected, name + "an edit at the largest offset does not append");
+		compare(name + "edit at the largest offset", document, max_errors);
+	}
+	return finish("incremental");
+}
@@ -0,0 +1,234 @@
+// the lexer has to give the same tokens as the original character by character one, with every skipper the cpu could pick,
+// and lexing in parallel has to give the same tokens as lexing in one go
+#include "common.h"
+
+#include <random>
+#include <regex>
+
+/**
+ * the lexer the table driven one replaced, kept as it was apart from working on offsets instead of copies,
+ * and the keyword count, which left out serve and structure
+ */
+namespace Reference{
+	using namespace Lexer;
+
+	struct Token{
+		TokenType type;
+		uint32_t offset;
+		uint32_t length;
+		int line;
+		std::string debug;
+	};
+
+	const std::regex LIT_NUMBER(R"(\d+(\.\d+)?)");
+	const std::regex IDENTIFIER(R"([a-zA-Z_][a-zA-Z0-9_]*(\\.[a-zA-Z_][a-zA-Z0-9_]*)*)");
+
+	const std::pair<std::string, TokenType> KEYWORDS[] = {
+		{"void", TOKEN_TYPE}, {"num", TOKEN_TYPE}, {"str", TOKEN_TYPE}, {"NULL", TOKEN_NULL}, {"null", TOKEN_NULL},
+		{"true", TOKEN_NUMBER}, {"false", TOKEN_NUMBER}, {"static", TOKEN_KEYWORD}, {"macro", TOKEN_KEYWORD},
+		{"func", TOKEN_KEYWORD}, {"namespace", TOKEN_KEYWORD}, {"merge", TOKEN_KEYWORD}, {"to", TOKEN_KEYWORD},
+		{"serve", TOKEN_KEYWORD}, {"structure", TOKEN_KEYWORD},
+	};
+
+	const std::pair<std::string, TokenType> MULTI[] = {
+		{"*\"", TOKEN_MULTILINE_STRING_START},
+		{"\"*", TOKEN_MULTILINE_STRING_END},
+	};
+
+	TokenType single(char c){
+		// only the first 15 of the operators were ever looked at
+		if (std::string_view("+-*:;&|^~<>=%#{").find(c) != std::string_view::npos)
+			return TOKEN_OPERATOR;
+		switch (c){
+			case '\n': return TOKEN_NEWLINE;
+			case '[':  return TOKEN_SQ_BRACKET_O;
+			case ']':  return TOKEN_SQ_BRACKET_C;
+			case '(':  return TOKEN_BRACKET_O;
+			case ')':  return TOKEN_BRACKET_C;
+			case ',':  return TOKEN_COMMA;
+			case '"':  return TOKEN_QUOTE;
+			default:   return TOKEN_UNKNOWN;
+		}
+	}
+
+	// turns whitespace catching on or off like the token says, and notes it
+	void toggle(Token& token, bool& catch_whitespace){
+		if (!catch_whitespace and 1 << token.type & start_ws_ignore){
+			catch_whitespace = true;
+			token.debug += "+";
+		}
+		else if (catch_whitespace and 1 << token.type & stop_ws_ignore){
+			catch_whitespace = false;
+			token.debug += "-";
+		}
+	}
+
+	std::vector<Token> tokenize(std::string_view source){
+		std::string code(source);
+		// ensure that no trailing tokens are missed
+		code += ' ';
+		std::vector<Token> tokens;
+		int line = 1;
+		bool catch_whitespace = false;
+		uint32_t word_start = 0;
+		uint32_t word_length = 0;
+		for (uint32_t i = 0; i < code.size(); i++){
+			Token special = {TOKEN_UNKNOWN, i, 1, line, ""};
+			for (const auto& [text, type] : MULTI)
+				if (code.compare(i, text.size(), text) == 0){
+					special.type = type;
+					special.length = text.size();
+					i += text.size() - 1;
+					break;
+				}
+			if (special.type == TOKEN_UNKNOWN)
+				special.type = single(code[i]);
+
+			if (not ((code[i] == ' ' or code[i] == '\t') and not catch_whitespace or special.type != TOKEN_UNKNOWN)){
+				if (word_length == 0)
+					word_start = i;
+				word_length++;
+				continue;
+			}
+
+			std::string separator = code[i] == ' ' ? "W" : "S";
+			std::string catching = catch_whitespace ? "C" : " ";
+			if (word_length == 0){
+				if (special.type != TOKEN_UNKNOWN){
+					special.debug = separator + catching + "a";
+					toggle(special, catch_whitespace);
+					tokens.push_back(special);
+					if (special.type == TOKEN_NEWLINE)
+						line++;
+				}
+				continue;
+			}
+
+			std::string word = code.substr(word_start, word_length);
+			Token token = {TOKEN_UNKNOWN, word_start, word_length, line, separator + catching + "b"};
+			for (const auto& [keyword, type] : KEYWORDS)
+				if (word == keyword){
+					token.type = type;
+					break;
+				}
+			if (token.type == TOKEN_UNKNOWN and std::regex_match(word, LIT_NUMBER))
+				token.type = TOKEN_NUMBER;
+			else if (token.type == TOKEN_UNKNOWN and std::regex_match(word, IDENTIFIER))
+				token.type = TOKEN_IDENTIFIER;
+			toggle(token, catch_whitespace);
+			tokens.push_back(token);
+
+			if (special.type != TOKEN_UNKNOWN){
+				special.debug = separator + catching + "c";
+				toggle(special, catch_whitespace);
+				if (special.type == TOKEN_NEWLINE)
+					line++;
+				tokens.push_back(special);
+			}
+			word_length = 0;
+		}
+		return tokens;
+	}
+}
+
+// pieces sources are made of, runs longer than a vector register and bytes the language has no use for included
+std::string random_source(std::mt19937& random, size_t size){
+	static const std::vector<std::string> pieces = {
+		" ", "  ", "\t", "\n", "\n", "(", ")", "[", "]", ",", "\"", "*\"", "\"*", "+", "-", "*", "->", "=", "@", "\\", "?",
+		"x", "abc", "a_b9", "_", "9a", "12", "3.25", "1.", ".5", "1.2.3", "a.b", "a\\.b", "$", "\xc3\xa9", "\x01", "\xff",
+		"num", "str", "void", "null", "NULL", "true", "false", "static", "macro", "func", "namespace", "merge", "to", "serve",
+		"structure", "serves", "nu", "static func num f(num a)[\n\tserve a\n]\n",
+		std::string(40, ' '), std::string(70, 'z'), std::string(33, '7'), std::string(50, '\t'), "abcdefghijklmnopqrstuvwxyz0123456789_ABCDEFGHIJ",
+	};
+	std::string code;
+	while (code.size() < size)
+		code += pieces[random() % pieces.size()];
+	return code;
+}
+
+void compare_with_reference(const std::string& name, std::string_view code){
+	Lexer::TokenBuffer tokens = Lexer::tokenize(code, true);
+	std::vector<Reference::Token> expected = Reference::tokenize(code);
+	check(tokens.size() == expected.size(), name + ": " + std::to_string(tokens.size()) + " tokens, " + std::to_string(expected.size()) + " expected");
+	for (size_t i = 0; i < std::min(tokens.size(), expected.size()); i++){
+		const Reference::Token& token = expected[i];
+		if (
+			    tokens.type(i) != token.type or tokens.offsets[i] != token.offset or tokens.lengths[i] != token.length
+			or tokens.line(i) != token.line or Lexer::debug_string(tokens.debug[i]) != token.debug
+		){
+			check(false, name + ": token " + std::to_string(i) + " at " + std::to_string(token.offset) + " differs");
+			return;
+		}
+	}
+}
+
+// every start and length of runs made mostly of members of the set, against a plain loop
+void compare_skippers(const std::string& name, std::mt19937& random){
+	using namespace Lexer::Scan;
+	for (int set = 0; set < SET_COUNT; set++){
+		std::vector<unsigned char> members;
+		for (int c = 0; c < 256; c++)
+			if (member((Set) set, c))
+				members.push_back(c);
+		for (int round = 0; round < 200; round++){
+			std::string buffer(100, ' ');
+			for (char& c : buffer)
+				c = random() % 16 == 0 ? (char) (random() % 256) : members[random() % members.size()];
+			for (size_t begin = 0; begin < buffer.size(); begin++)
+				for (size_t end = begin; end <= buffer.size(); end++){
+					const char* p = buffer.data() + begin;
+					while (p != buffer.data() + end and member((Set) set, *p))
+						p++;
+					if (level != LEVEL_NONE and SKIP[set](buffer.data() + begin, buffer.data() + end) != p){
+						check(false, name + ": set " + std::to_string(set) + " skips wrong from " + std::to_string(begin) + " to " + std::to_string(end));
+						return;
+					}
+				}
+		}
+	}
+}
+
+void compare_parallel(const std::string& name, std::string_view code, Threads::Pool& pool){
+	Lexer::TokenBuffer one;
+	one.code = code;
+	one.lines.code = code;
+	one.lines.starts.push_back(0);
+	Lexer::tokenize_range<true>(code, 0, false, one);
+	Lexer::TokenBuffer parallel = Lexer::Parallel::tokenize<true>(code, pool);
+	check(one.types == parallel.types, name + ": types differ");
+	check(one.offsets == parallel.offsets, name + ": offsets differ");
+	check(one.lengths == parallel.lengths, name + ": lengths differ");
+	check(one.debug == parallel.debug, name + ": debug flags differ");
+	check(one.lines.starts == parallel.lines.starts, name + ": line starts differ");
+}
+
+int main(){
+	using namespace Lexer::Scan;
+	std::mt19937 random(7);
+
+	// the cpu may not have all of them, then the best it has is what is left to test
+	const std::pair<Level, const char*> levels[] = {
+		{LEVEL_NONE, "none"}, {LEVEL_SCALAR, "scalar"}, {LEVEL_SSE2, "sse2"}, {LEVEL_AVX2, "avx2"},
+	};
+	for (const auto& [wanted, name] : levels){
+		Level got = select(wanted);
+		if (got != wanted){
+			printf("%s: not supported here, skipped\n", name);
+			continue;
+		}
+		compare_skippers(name, random);
+		compare_with_reference(std::string(name) + ", test.fuss", "static func num f(num a, num b, str c)[\n\tserve a+b+c\n]\nf(1,    2  , \"abc\")\n1+*\"abc\n \"def\n \"*\n");
+		for (int i = 0; i < 300; i++)
+			compare_with_reference(std::string(name) + ", source " + std::to_string(i), random_source(random, 1 + random() % 3000));
+		compare_with_reference(std::string(name) + ", long source", random_source(random, 1 << 17));
+		// the last word runs into the end of the input, in and out of a string
+		compare_with_reference(std::string(name) + ", word at the end", "x = abc");
+		compare_with_reference(std::string(name) + ", string at the end", "x = \"abc def");
+	}
+	select(LEVEL_AVX2);
+
+	Threads::Pool pool(4);
+	for (int i = 0; i < 3; i++)
+		compare_parallel("parallel source " + std::to_string(i), random_source(random, Lexer::Parallel::MIN_SIZE + random() % 100000), pool);
+	return finish("lexer");
+}
@@ -0,0 +1,65 @@
+// the object cache finds what was stored under the same key, asks for the compiler's version once,
+// and evicts the least recently used objects first
+#include "common.h"
+
+namespace fs = std::filesystem;
+
+// an object file of size bytes
+std::string object(const std::string& directory, const std::string& name, size_t size){
+	std::string path = directory + "/" + name + ".o";
+	std::ofstream(path, std::ios::binary) << std::string(size, name[0]);
+	return path;
+}
+
+int main(){
+	std::string directory = temporary_directory();
+	std::string compiler = fake_compiler(directory);
+	const uint64_t LIMIT = 3000;
+
+	Objects::Store store(directory + "/objects", LIMIT);
+	check(store.open(compiler, "-c"), "the store does not open");
+	Objects::Store again(directory + "/objects", LIMIT);
+	check(again.open(compiler, "-c"), "the store does not open a second time");
+	int asked = 0;
+	for (const std::string& line : lines(directory + "/log"))
+		asked += line == "--version";
+	check(asked == 1, "the version was asked for " + std::to_string(asked) + " times");
+
+	// keys depend on the header, the unit and the flags
+	uint64_t a = store.key("header", "unit a");
+	check(a == again.key("header", "unit a"), "the same unit gets another key");
+	check(a != store.key("header", "unit b"), "another unit gets the same key");
+	check(a != store.key("other header", "unit a"), "another header gets the same key");
+	Objects::Store optimized(directory + "/objects", LIMIT);
+	check(optimized.open(compiler, "-c -O2") and a != optimized.key("header", "unit a"), "other flags get the same key");
+
+	check(store.find(a).empty(), "an object is found before it was stored");
+	store.store(a, object(directory, "a", 1000));
+	std::string found = store.find(a);
+	check(not found.empty() and fs::file_size(found) == 1000, "the stored object is not found");
+	check(store.statistics().hits == 1 and store.statistics().misses == 1, "hits and misses are not counted");
+
+	// b and c are stored after a, but a is used again last, so b goes first
+	uint64_t b = store.key("header", "unit b");
+	uint64_t c = store.key("header", "unit c");
+	store.store(b, object(directory, "b", 1000));
+	store.store(c, object(directory, "c", 1000));
+	auto now = fs::file_time_type::clock::now();
+	fs::last_write_time(store.find(a), now - std::chrono::seconds(300));
+	fs::last_write_time(store.find(b), now - std::chrono::seconds(200));
+	fs::last_write_time(store.find(c), now - std::chrono::seconds(100));
+	store.find(a);
+	store.trim();
+	check(store.statistics().evicted == 0, "objects are evicted under the limit");
+
+	uint64_t d = store.key("header", "unit d");
+	store.store(d, object(directory, "d", 1000));
+	store.trim();
+	const Objects::Store::Stats& stats = store.statistics();
+	check(stats.evicted == 1 and stats.objects == 3 and stats.bytes == 3000, "not just one object was evicted");
+	check(not store.find(a).empty() and not store.find(c).empty() and not store.find(d).empty(), "a used object was evicted");
+	check(store.find(b).empty(), "the least recently used object was kept");
+
+	fs::remove_all(directory);
+	return finish("objects");
+}
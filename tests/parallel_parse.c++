@@ -0,0 +1,34 @@
+// the parallel parse has to give the same tree and errors as a parse in one go, also when it stops at the limit of errors
+#include "common.h"
+
+// lines of statements, with a broken one every error_every lines
+std::string source(int lines, int error_every){
+	std::string code;
+	for (int i = 0; i < lines; i++){
+		if (i % error_every == error_every - 1)
+			code += "1 + * 2\n";
+		else if (i % 7 == 0)
+			code += "static func num f" + std::to_string(i) + "(num a, num b 2)[\n\tserve a + b * " + std::to_string(i) + "\n]\n";
+		else
+			code += "f" + std::to_string(i / 7 * 7) + "(" + std::to_string(i) + ", x - 3) + \"s\"\n";
+	}
+	return code;
+}
+
+void compare(const std::string& name, const std::string& code, uint32_t max_errors, Threads::Pool& pool){
+	Lexer::TokenBuffer tokens = Lexer::tokenize(code, false);
+	Parser::ParseResult one = Parser::Reader<false>(tokens, max_errors, 0, tokens.size()).parse();
+	Parser::ParseResult parallel = Parser::Parallel::parse(tokens, max_errors, pool);
+	Compare::trees(name, one.tree, parallel.tree);
+	Compare::results(name, one, code, parallel, code);
+}
+
+int main(){
+	Threads::Pool pool(4);
+	compare("no errors", source(20000, 1 << 30), 20, pool);
+	compare("limit reached early", source(20000, 50), 20, pool);
+	compare("limit reached late", source(20000, 900), 20, pool);
+	compare("limit of one", source(20000, 3000), 1, pool);
+	compare("no limit", source(20000, 50), 0, pool);
+	return finish("parallel_parse");
+}